@@ -9,17 +9,26 @@
 #pragma comment(lib, "d3d9.lib")
 
 // Other includes
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <random>
-#include <numeric>
 #include <sstream>
 
 #include "types/vec2.h"
+#include "fpl/generator.h"
+#include "fpl/stats.h"
+#include "fpl/job.h"
+#include "fpl/cache.h"
+#include "fpl/tree.h"
+#include "render/polyline.h"
 
 namespace globals {
     std::vector<vec2> g_points;
     std::vector<vec2> g_fpl;
+
+    // Changes every time g_fpl does
+    uint64_t g_fpl_rev = 0;
 }
 
 namespace vars {
@@ -28,8 +37,23 @@ namespace vars {
 
     int v_n = 25;
 
+    // Adaptive N: from v_n up to v_n_max realisations, until the CI's are within v_tol of the averages
+    bool v_adaptive = false;
+    int v_n_max = 400;
+    float v_tol = 0.02f;
+
+    bool v_ci_bands = true; // 95% CI's of the charts as shaded bands
+
+    bool v_crn = false; // Common random numbers: the same realisations for every sweep value
+
     int v_gen_type = 1; // 0 - normal, 1 - uniform
 
+    int v_precision = 0; // 0 - float, 1 - double, 2 - fixed 16.16
+
+    uint64_t v_seed = 1; // Same seed -> same FPL and charts
+
+    bool v_thin_lines = true; // 1 px lines for FPL's over render::thin_line_threshold points
+
     namespace normal {
         float v_stddev = 0.2f;
     }
@@ -41,22 +65,56 @@ namespace vars {
 }
 
 namespace plots {
-    std::vector<float> pl_x;
-    std::vector<float> pl_max;
-    std::vector<float> pl_mean;
-    std::vector<float> pl_elong;
-
-    std::vector<float> pl3_log2elong;
-    std::vector<int> pl3_x;
-
-    float ar_x[ 256 ] = {};
-    float ar_max[ 256 ] = {};
-    float ar_mean[ 256 ] = {};
-    float ar_elong[ 256 ] = {};
-    float ar_log2elong[ 256 ] = {};
-
-    float ar3_log2elong[ 256 ] = {};
-    float ar3_x[ 256 ] = {};
+    // Series of the charts, plotted straight from these buffers
+    fpl::series g_series;
+
+    // Average -/+ CI of a series, made once per result
+    struct band {
+        std::vector<float> lo;
+        std::vector<float> hi;
+
+        void set( const std::vector<float> &avg, const std::vector<float> &ci ) {
+            lo.resize( avg.size( ) );
+            hi.resize( avg.size( ) );
+
+            for ( size_t i = 0; i < avg.size( ); ++i ) {
+                lo[ i ] = avg[ i ] - ci[ i ];
+                hi[ i ] = avg[ i ] + ci[ i ];
+            }
+        }
+    };
+
+    band g_max, g_mean, g_elong, g_log2elong;
+}
+
+namespace jobs {
+    // Result of one update_fpl: the FPL first, then the charts (or both at once)
+    struct fpl_result {
+        uint64_t generation = 0;
+
+        bool has_fpl = false;
+        std::vector<vec2> fpl;
+
+        bool has_stats = false;
+        fpl::series series;
+        bool stats_ok = false;
+    };
+
+    // Generation of the newest update_fpl, older results are dropped
+    uint64_t g_generation = 0;
+
+    // Before g_worker, so it outlives the jobs
+    fpl::snapshot<fpl_result> g_result;
+
+    // FPL's and charts of the recent settings: going back to them takes no time
+    fpl::result_cache g_cache;
+
+    // Levels of the FPL made so far, only R changed -> only the new levels are made
+    // Used by the jobs only (one at a time)
+    fpl::fpl_tree g_tree;
+
+    // FPL + stats run here, off the GUI thread
+    fpl::latest_job g_worker;
 }
 
 // Data
@@ -72,399 +130,275 @@ LRESULT WINAPI WndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam );
 
 void clear_plots( ) {
     // Clears plots stuff
-    plots::pl_x.clear( );
-    plots::pl_max.clear( );
-    plots::pl_mean.clear( );
-    plots::pl_elong.clear( );
-
-    plots::pl3_log2elong.clear( );
-    plots::pl3_x.clear( );
-
-    for ( int i = 0; i < 256; ++i ) {
-        plots::ar_x[ i ] = 0.f;
-        plots::ar_max[ i ] = 0.f;
-        plots::ar_mean[ i ] = 0.f;
-        plots::ar_elong[ i ] = 0.f;
-        plots::ar_log2elong[ i ] = 0.f;
-
-        plots::ar3_log2elong[ i ] = 0.f;
-        plots::ar3_x[ i ] = 0.f;
-    }
+    plots::g_series.clear( );
 }
 
-float get_avg( const std::vector<float> &vec ) {
-    if ( vec.empty( ) ) {
-        return 0.f;
-    }
-
-    const auto count = static_cast< float >( vec.size( ) );
-    return std::reduce( vec.begin( ), vec.end( ) ) / count;
+fpl::settings get_settings( ) {
+    fpl::settings cfg;
+    cfg.r = vars::v_recurs;
+    cfg.delta = vars::v_delta;
+    cfg.n = vars::v_n;
+    cfg.adaptive = vars::v_adaptive;
+    cfg.n_max = vars::v_n_max;
+    cfg.tol = vars::v_tol;
+    cfg.crn = vars::v_crn;
+    cfg.gen_type = vars::v_gen_type;
+    cfg.precision = vars::v_precision;
+    cfg.seed = vars::v_seed;
+    cfg.stddev = vars::normal::v_stddev;
+    cfg.j = vars::uniform::v_j;
+    cfg.sj = vars::uniform::v_sj;
+    return cfg;
 }
 
-float get_max( const std::vector<vec2> &points, const float &_y = 0.f ) {
-    auto ret = *std::max_element( points.begin( ), points.end( ), [ & ]( const vec2 &a, const vec2 &b ) {
-        auto a_y = std::fabsf( a.y - _y );
-        auto b_y = std::fabsf( b.y - _y );
-        return a_y < b_y;
-    } );
-
-    return std::fabsf( ret.y - _y );
-}
-
-float get_mean( const std::vector<vec2> &points, const float &_y = 0.f ) {
-    float sum = 0.f;
-    for ( const auto &p : points ) {
-        sum += std::fabsf( p.y - _y );
-    }
-
-    auto ret = sum / points.size( );
-    return ret;
-}
-
-float get_elong( const std::vector<vec2> &points ) {
-    float sum = 0.f;
-    for ( size_t i = 0; i < points.size( ) - 1; ++i ) {
-        auto vec = points[ i ] - points[ i + 1 ];
-        sum += vec.length( );
-    }
-
-    auto vec_ab = points[ 0 ] - points.back();
-    auto vec_ab_len = vec_ab.length( );
-
-    auto ret = sum / vec_ab_len;
-    return ret;
-}
-
-std::tuple<float, float, float> do_stat( const std::vector<vec2> &src_points, const std::vector<vec2> &fpl_points ) {
-    // Doing statistics only for line segment
-    if ( src_points.size( ) != 2 ) {
-        return std::make_tuple( 0.f, 0.f, 0.f );
-    }
-
-    // Check if we have any FPL's
-    if ( fpl_points.empty( ) ) {
-        return std::make_tuple( 0.f, 0.f, 0.f );
+void set_plots( fpl::series &series, bool stats_ok ) {
+    // Failed to get stats
+    if ( !stats_ok ) {
+        plots::g_series.clear( );
+        return;
     }
 
-    // Current y = (a.y - b.y) / 2
-    auto y = ( src_points[ 0 ].y + src_points[ 1 ].y ) / 2;
-    
-    // Getting max dev
-    auto max_dev = get_max( fpl_points, y );
+    // The old buffers go back to the result and are freed with it
+    std::swap( plots::g_series, series );
 
-    // Getting mean dev
-    auto mean_dev = get_mean( fpl_points, y );
-
-    // Getting elongation factor
-    auto elong_fact = get_elong( fpl_points );
-
-    return std::make_tuple( max_dev, mean_dev, elong_fact );
+    const auto &cur = plots::g_series;
+    plots::g_max.set( cur.max, cur.max_ci );
+    plots::g_mean.set( cur.mean, cur.mean_ci );
+    plots::g_elong.set( cur.elong, cur.elong_ci );
+    plots::g_log2elong.set( cur.log2elong, cur.log2elong_ci );
 }
 
-float get_rf( float stddev, float s ) {
-    std::random_device rd {};
-    std::mt19937 gen { rd( ) };
-
-    float ret = 0.f;
-
-    // Normal dist
-    if ( vars::v_gen_type == 0 ) {
-        std::normal_distribution<float> dis( 0.f, stddev );
-        ret = dis( gen );
-    }
-    // Uniform dist
-    else if ( vars::v_gen_type == 1 ) {
-        std::uniform_real_distribution<float> dis( -s, s );
-        ret = dis( gen );
+// dragging: a point is being dragged, the FPL only (from the float tree for every precision: drawn as float anyway);
+// the cache and the charts wait for the update_fpl on release
+void update_fpl( bool dragging = false ) {
+    // Doing FPL only if we have start points
+    if ( globals::g_points.size( ) < 2 ) {
+        return;
     }
-    
-    return ret;
-}
-
-std::vector<vec2> FPLrec( std::vector<vec2> list_a, vec2 point_b, int r, int delta, float stddev, float s ) {
-    auto vec_a = list_a.back( );
-    auto vec_b = point_b;
-
-    // Getting the length of the segment ab
-    auto vec_v = vec_b - vec_a;
-    auto v_len = vec_v.length( );
 
-    // Recursion stop condition
-    if ( r == 0 || v_len < delta ) {
-        list_a.push_back( vec_b );
-        return list_a;
+    // Fixed 16.16 would saturate further out
+    if ( !fpl::in_range( vars::v_precision, globals::g_points ) ) {
+        std::cout << "[error] fixed precision takes coordinates within " << fpl::fixed_range << " only! Line: " << __LINE__ << std::endl;
+        return;
     }
 
-    // Middle point
-    auto c = ( vec_a + vec_b ) / 2;
-
-    // Middle points offset
-    auto rotv = vec_v.rotate( 90.f );
-    auto rf = get_rf( stddev, s );
-    auto d = vec2( c.x + rf * rotv.x, c.y + rf * rotv.y );
-
-    // Splitting the segment ad
-    list_a = FPLrec( list_a, d, --r, delta, stddev, s );
+    // Results of the older jobs are stale now
+    const auto generation = ++jobs::g_generation;
 
-    // Splitting the segment ab
-    return FPLrec( list_a, vec_b, r, delta, stddev, s );
-}
-
-std::vector<vec2> do_fpl( int r, int delta, float stddev, float s ) {
-    std::vector<vec2> fpl;
+    // The job works on its own copies, the canvas keeps drawing the last result meanwhile
+    jobs::g_worker.submit( [ cfg = get_settings( ), points = globals::g_points, generation, dragging ]( const std::atomic<bool> &cancel ) {
+        jobs::fpl_result result;
+        result.generation = generation;
 
-    // Main loop (proc 2 points - i and i + 1)
-    for ( size_t i = 0; i < globals::g_points.size( ); i += 2 ) {
-        std::vector<vec2> Lp;
-        Lp.push_back( globals::g_points[ i ] ); // Point a
-        auto vec_b = globals::g_points[ i + 1 ]; // Point b
+        // Getting FPL's
+        const auto fpl_key = fpl::fpl_key( points, cfg );
+        if ( !jobs::g_cache.get( fpl_key, result.fpl ) ) {
+            // The tree keeps float levels only, it splices the moved segments into the polyline it kept
+            if ( cfg.precision == fpl::prec_float || dragging ) {
+                jobs::g_tree.reset( points, cfg );
+                jobs::g_tree.set_depth( cfg.r, &fpl::pool::shared( ) );
 
-        // Getting FPLs
-        auto fpl_points = FPLrec( Lp, vec_b, r, delta, stddev, s );
-
-        // Processing FPL points
-        for ( size_t n = 0; n < fpl_points.size( ); ++n ) {
-            // It's a last coord (point b)
-            if ( n + 1 >= fpl_points.size( ) ) {
-                fpl.push_back( fpl_points[ n ] );
-                break;
+                result.fpl = jobs::g_tree.polyline( nullptr, &fpl::pool::shared( ) );
             }
-
-            // If we have the same coords: src(x,y) = dst(x,y) -> skip
-            if ( !fpl.empty() && fpl.back() == fpl_points[ n ] ) {
-                continue;
+            else {
+                result.fpl = fpl::do_fpl( points, cfg, &fpl::pool::shared( ) );
             }
-
-            // !Probably never called here!
-            // Search the main points ab and remove them
-            auto it_a = std::find( globals::g_points.begin( ), globals::g_points.end( ), fpl_points[ n ] );
-            auto it_b = std::find( globals::g_points.begin( ), globals::g_points.end( ), fpl_points[ n + 1 ] );          
-            
-            // Skip if its points from a main lines
-            if ( it_a != globals::g_points.end( ) && it_b != globals::g_points.end( ) ) {
-                // Inc iterator a to get it equal to it_b
-                it_a++;
-
-                if ( it_a != globals::g_points.end( ) && it_a == it_b ) {
-                    continue;
-                }
+            if ( result.fpl.empty( ) ) {
+                std::cout << "[error] fpls = 0! Line: " << __LINE__ << std::endl;
+                return;
             }
 
-            fpl.push_back( fpl_points[ n ] );
+            if ( !dragging ) {
+                jobs::g_cache.put( fpl_key, result.fpl );
+            }
         }
 
-        // Clear buffer
-        Lp.clear( );
-    }
+        if ( cancel ) {
+            return;
+        }
 
-    return fpl;
-}
+        // The FPL shows up right away, the charts once they're done
+        result.has_fpl = true;
+        jobs::g_result.publish( result );
 
-void get_stats( int r, int delta, float stddev, float s ) {
-    // Doing charts stuff
-    // Uniform div
-    if ( vars::v_gen_type == 1 ) {
-        // From sj to sj * j to charts 1, 2
-        for ( int j = 1; j <= vars::uniform::v_j; ++j ) {
-            float sj = vars::uniform::v_sj * j;
-
-            std::vector<float> tmp_max;
-            std::vector<float> tmp_mean;
-            std::vector<float> tmp_elong;
-
-            // Makes N's FPL's
-            for ( int i = 0; i < vars::v_n; ++i ) {
-                auto fpls = do_fpl( r, delta, stddev, sj );
-
-                // Calc stats
-                float t_max = 0.f, t_mean = 0.f, t_elong = 0.f;
-                std::tie( t_max, t_mean, t_elong ) = do_stat( globals::g_points, fpls );
-
-                // Failed to get stats
-                if ( t_max == 0.f && t_mean == 0.f && t_elong == 0.f ) {
-                    std::cout << "[error] stats = 0! Line: " << __LINE__ << std::endl;
-                    return;
-                }
+        if ( dragging ) {
+            return;
+        }
 
-                tmp_max.push_back( t_max );
-                tmp_mean.push_back( t_mean );
-                tmp_elong.push_back( t_elong );
+        // Getting stats for charts
+        jobs::fpl_result stats;
+        stats.generation = generation;
+        stats.has_stats = true;
+
+        const auto stats_key = fpl::stats_key( points, cfg );
+        stats.stats_ok = jobs::g_cache.get( stats_key, stats.series );
+        if ( !stats.stats_ok ) {
+            stats.stats_ok = fpl::get_stats( points, cfg, stats.series, fpl::pool::shared( ), &cancel );
+            if ( cancel ) {
+                return;
             }
 
-            float avg_max = get_avg( tmp_max );
-            float avg_mean = get_avg( tmp_mean );
-            float avg_elong = get_avg( tmp_elong );
-
-            plots::pl_max.push_back( avg_max );
-            plots::pl_mean.push_back( avg_mean );
-            plots::pl_elong.push_back( avg_elong );
-
-            plots::pl_x.push_back( sj );
+            // Only complete charts
+            if ( stats.stats_ok ) {
+                jobs::g_cache.put( stats_key, stats.series );
+            }
         }
 
-        // From 1 to r for chart 3
-        for ( int i = 1; i <= r; ++i ) {
-            int ri = i;
-
-            std::vector<float> tmp_log2elong;
-
-            // Makes N's FPL's
-            for ( int i = 0; i < vars::v_n; ++i ) {
-                auto fpls = do_fpl( ri, delta, stddev, s );
+        // The FPL wasn't taken yet, it goes along with the charts
+        jobs::fpl_result pending;
+        if ( jobs::g_result.consume( pending ) && pending.generation == generation && pending.has_fpl ) {
+            stats.has_fpl = true;
+            stats.fpl = std::move( pending.fpl );
+        }
 
-                // Calc stats
-                float t_max = 0.f, t_mean = 0.f, t_elong = 0.f;
-                std::tie( t_max, t_mean, t_elong ) = do_stat( globals::g_points, fpls );
+        jobs::g_result.publish( stats );
+    } );
+}
 
-                // Failed to get stats
-                if ( t_max == 0.f && t_mean == 0.f && t_elong == 0.f ) {
-                    std::cout << "[error] stats = 0! Line: " << __LINE__ << std::endl;
-                    return;
-                }
+void cancel_fpl( ) {
+    ++jobs::g_generation;
+    jobs::g_worker.cancel( );
+}
 
-                tmp_log2elong.push_back( std::log2f( t_elong ) );
-            }
+// Takes the newest complete result of update_fpl, once per frame
+void poll_fpl( ) {
+    jobs::fpl_result result;
+    if ( !jobs::g_result.consume( result ) ) {
+        return;
+    }
 
-            float avg_log2elong = get_avg( tmp_log2elong );
+    // Parameters changed or canvas cleared since this job started
+    if ( result.generation != jobs::g_generation ) {
+        return;
+    }
 
-            plots::pl3_log2elong.push_back( avg_log2elong );
+    // Filling the main array with FPL
+    if ( result.has_fpl ) {
+        globals::g_fpl = std::move( result.fpl );
+        ++globals::g_fpl_rev;
+    }
 
-            plots::pl3_x.push_back( ri );
-        }
+    // The charts of the last FPL stay until the new ones are done
+    if ( result.has_stats ) {
+        clear_plots( );
+        set_plots( result.series, result.stats_ok );
+    }
+}
 
-        // Updating plots arrays
-        for ( size_t i = 0; i < plots::pl_x.size( ); ++i ) {
-            plots::ar_x[ i ] = plots::pl_x[ i ];
-            plots::ar_max[ i ] = plots::pl_max[ i ];
-            plots::ar_mean[ i ] = plots::pl_mean[ i ];
-            plots::ar_elong[ i ] = plots::pl_elong[ i ];
-            plots::ar_log2elong[ i ] = std::log2f( plots::pl_elong[ i ] );
-        }
+// Sliders recompute the FPL only if it's drawn (or on the way)
+bool has_fpl( ) {
+    return !globals::g_fpl.empty( ) || jobs::g_worker.busy( );
+}
 
-        for ( size_t i = 0; i < plots::pl3_x.size( ); ++i ) {
-            plots::ar3_x[ i ] = static_cast< int >( plots::pl3_x[ i ] );
-            plots::ar3_log2elong[ i ] = plots::pl3_log2elong[ i ];
+// Index of the main point within radius of pos (the last one drawn on top), -1 if none
+int pick_point( const vec2 &pos, float radius ) {
+    const auto &points = globals::g_points;
+    for ( size_t n = points.size( ); n-- > 0; ) {
+        if ( ( points[ n ] - pos ).length( ) <= radius ) {
+            return static_cast< int >( n );
         }
     }
-    else if ( vars::v_gen_type == 0 ) {
-        // From 0 to stddev with step 0.01 | For chart 1, 2
-        for ( float i = 0.01f; i <= vars::normal::v_stddev; i += 0.01f ) {
-            float stddevi = i;
-
-            std::vector<float> tmp_max;
-            std::vector<float> tmp_mean;
-            std::vector<float> tmp_elong;
-
-            // Makes N's FPL's
-            for ( int i = 0; i < vars::v_n; ++i ) {
-                auto fpls = do_fpl( r, delta, stddevi, s );
-
-                // Calc stats
-                float t_max = 0.f, t_mean = 0.f, t_elong = 0.f;
-                std::tie( t_max, t_mean, t_elong ) = do_stat( globals::g_points, fpls );
-
-                // Failed to get stats
-                if ( t_max == 0.f && t_mean == 0.f && t_elong == 0.f ) {
-                    std::cout << "[error] stats = 0! Line: " << __LINE__ << std::endl;
-                    return;
-                }
 
-                tmp_max.push_back( t_max );
-                tmp_mean.push_back( t_mean );
-                tmp_elong.push_back( t_elong );
-            }
-
-            float avg_max = get_avg( tmp_max );
-            float avg_mean = get_avg( tmp_mean );
-            float avg_elong = get_avg( tmp_elong );
-
-            plots::pl_max.push_back( avg_max );
-            plots::pl_mean.push_back( avg_mean );
-            plots::pl_elong.push_back( avg_elong );
+    return -1;
+}
 
-            plots::pl_x.push_back( stddevi );
+// Indices of every main point at point: a vertex of a chain is point b of one segment and point a of the next
+std::vector<size_t> points_at( const vec2 &point ) {
+    std::vector<size_t> ret;
+    for ( size_t n = 0; n < globals::g_points.size( ); ++n ) {
+        if ( globals::g_points[ n ] == point ) {
+            ret.push_back( n );
         }
+    }
 
-        // From 1 to r | Chart 3
-        for ( int i = 1; i <= r; ++i ) {
-            int ri = i;
-
-            std::vector<float> tmp_log2elong;
-
-            // Makes N's FPL's
-            for ( int i = 0; i < vars::v_n; ++i ) {
-                auto fpls = do_fpl( ri, delta, stddev, s );
-
-                // Calc stats
-                float t_max = 0.f, t_mean = 0.f, t_elong = 0.f;
-                std::tie( t_max, t_mean, t_elong ) = do_stat( globals::g_points, fpls );
-
-                // Failed to get stats
-                if ( t_max == 0.f && t_mean == 0.f && t_elong == 0.f ) {
-                    std::cout << "[error] stats = 0! Line: " << __LINE__ << std::endl;
-                    return;
-                }
+    return ret;
+}
 
-                tmp_log2elong.push_back( std::log2f( t_elong ) );
-            }
+// Removes the vertex at index n: a chain going through it is joined over it, other segments on it go
+void remove_point( size_t n ) {
+    auto &points = globals::g_points;
 
-            float avg_log2elong = get_avg( tmp_log2elong );
+    // The first point, no segment yet
+    if ( points.size( ) < 2 ) {
+        points.clear( );
+        return;
+    }
 
-            plots::pl3_log2elong.push_back( avg_log2elong );
+    const auto point = points[ n ];
 
-            plots::pl3_x.push_back( ri );
+    // Segments ending and starting at the point
+    std::vector<size_t> in, out;
+    for ( size_t i = 0; i + 1 < points.size( ); i += 2 ) {
+        if ( points[ i + 1 ] == point ) {
+            in.push_back( i / 2 );
         }
-
-        // Updating plots arrays
-        for ( size_t i = 0; i < plots::pl_x.size( ); ++i ) {
-            plots::ar_x[ i ] = plots::pl_x[ i ];
-            plots::ar_max[ i ] = plots::pl_max[ i ];
-            plots::ar_mean[ i ] = plots::pl_mean[ i ];
-            plots::ar_elong[ i ] = plots::pl_elong[ i ];
-            plots::ar_log2elong[ i ] = std::log2f( plots::pl_elong[ i ] );
+        else if ( points[ i ] == point ) {
+            out.push_back( i / 2 );
         }
+    }
 
-        for ( size_t i = 0; i < plots::pl3_x.size( ); ++i ) {
-            plots::ar3_x[ i ] = static_cast< int >( plots::pl3_x[ i ] );
-            plots::ar3_log2elong[ i ] = plots::pl3_log2elong[ i ];
-        }
+    std::vector<size_t> gone;
+    if ( in.size( ) == 1 && out.size( ) == 1 ) {
+        points[ 2 * in[ 0 ] + 1 ] = points[ 2 * out[ 0 ] + 1 ];
+        gone = out;
+    }
+    else {
+        gone = in;
+        gone.insert( gone.end( ), out.begin( ), out.end( ) );
+        std::sort( gone.begin( ), gone.end( ) );
+    }
+
+    for ( size_t i = gone.size( ); i-- > 0; ) {
+        points.erase( points.begin( ) + 2 * gone[ i ], points.begin( ) + 2 * gone[ i ] + 2 );
     }
 }
 
-void update_fpl( ) {
-    // Doing FPL only if we have start points
-    if ( globals::g_points.size( ) < 2 ) {
+// List box that formats only its visible rows
+// - jump_to >= 0 scrolls to that row (once, then it's reset to -1)
+template <typename Fn>
+void coords_list_box( const char *label, int rows, int &jump_to, Fn &&draw_row ) {
+    if ( !ImGui::BeginListBox( label ) ) {
         return;
     }
 
-    // Clear prev stuff
-    if ( !globals::g_fpl.empty( ) ) {
-        globals::g_fpl.clear( );
+    const auto row_h = ImGui::GetTextLineHeightWithSpacing( );
 
-        clear_plots( );
+    if ( jump_to >= 0 ) {
+        ImGui::SetScrollY( jump_to * row_h );
+        jump_to = -1;
     }
 
-    // Variables for FPL
-    float stddev = vars::normal::v_stddev;
-    float s = vars::uniform::v_j * vars::uniform::v_sj;
-    int r = vars::v_recurs;
-    int delta = vars::v_delta;
-
-    // Getting FPL's
-    auto fpl_points = do_fpl( r, delta, stddev, s );
-    if ( fpl_points.empty( ) ) {
-        std::cout << "[error] fpls = 0! Line: " << __LINE__ << std::endl;
-        return;
+    ImGuiListClipper clipper;
+    clipper.Begin( rows, row_h );
+    while ( clipper.Step( ) ) {
+        for ( int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i ) {
+            draw_row( i );
+        }
     }
 
-    // Filling the main array with FPL
-    globals::g_fpl = fpl_points;
+    ImGui::EndListBox( );
+}
 
-    // Getting stats for charts
-    get_stats( r, delta, stddev, s );
+// Index of the point closest to p, -1 if there are none
+int find_nearest( const std::vector<vec2> &points, const vec2 &p ) {
+    int ret = -1;
+    float best = 0.f;
+
+    for ( size_t i = 0; i < points.size( ); ++i ) {
+        const auto v = points[ i ] - p;
+        const auto d = v.dot_product( v );
+        if ( ret < 0 || d < best ) {
+            best = d;
+            ret = static_cast< int >( i );
+        }
+    }
+
+    return ret;
 }
 
 static void ShowMainWindow( bool *p_open ) {
+    poll_fpl( );
+
     const ImGuiViewport *viewport = ImGui::GetMainViewport( );
     ImVec2 work_pos = viewport->WorkPos;
     ImVec2 work_size = viewport->WorkSize;
@@ -490,15 +424,19 @@ static void ShowMainWindow( bool *p_open ) {
                 static float bt_sz_y = 0;
 
                 if ( ImGui::Button( "Clear canvas", ImVec2( bt_sz_x, bt_sz_y ) ) ) {
+                    cancel_fpl( );
                     globals::g_points.clear( );
                     globals::g_fpl.clear( );
+                    ++globals::g_fpl_rev;
                     clear_plots( );
                 }
 
                 ImGui::SameLine( );
 
                 if ( ImGui::Button( "Clear FPL's", ImVec2( bt_sz_x, bt_sz_y ) ) ) {
+                    cancel_fpl( );
                     globals::g_fpl.clear( );
+                    ++globals::g_fpl_rev;
                     clear_plots( );
                 }
 
@@ -506,10 +444,16 @@ static void ShowMainWindow( bool *p_open ) {
                     update_fpl( );
                 }
 
+                // The canvas and charts show the last result until the new one is done
+                if ( jobs::g_worker.busy( ) ) {
+                    ImGui::SameLine( );
+                    ImGui::Text( "Computing..." );
+                }
+
                 // Recursion
-                if ( ImGui::SliderInt( "R", &vars::v_recurs, 1, 10 ) ) {
+                if ( ImGui::SliderInt( "R", &vars::v_recurs, 1, 16 ) ) {
                     // Update FPL only if we already drew it
-                    if ( !globals::g_fpl.empty( ) ) {
+                    if ( has_fpl( ) ) {
                         update_fpl( );
                     }
                 }
@@ -517,7 +461,7 @@ static void ShowMainWindow( bool *p_open ) {
                 // Min delta
                 if ( ImGui::SliderInt( "Delta", &vars::v_delta, 1, 10 ) ) {
                     // Update FPL only if we already drew it
-                    if ( !globals::g_fpl.empty( ) ) {
+                    if ( has_fpl( ) ) {
                         update_fpl( );
                     }
                 }
@@ -525,7 +469,15 @@ static void ShowMainWindow( bool *p_open ) {
                 ImGui::Separator( );
                 if ( ImGui::Combo( "Generator Type", &vars::v_gen_type, "Normal\0Uniform\0\0" ) ) {
                     // Update FPL only if we already drew it
-                    if ( !globals::g_fpl.empty( ) ) {
+                    if ( has_fpl( ) ) {
+                        update_fpl( );
+                    }
+                }
+
+                // Double keeps the deep levels that float rounds away, fixed has the same step on the whole canvas
+                if ( ImGui::Combo( "Precision", &vars::v_precision, "Float\0Double\0Fixed 16.16\0\0" ) ) {
+                    // Update FPL only if we already drew it
+                    if ( has_fpl( ) ) {
                         update_fpl( );
                     }
                 }
@@ -537,7 +489,7 @@ static void ShowMainWindow( bool *p_open ) {
                     // Standart deviation
                     if ( ImGui::SliderFloat( "Std dev", &vars::normal::v_stddev, 0.1f, 1.f ) ) {
                         // Update FPL only if we already drew it
-                        if ( !globals::g_fpl.empty( ) ) {
+                        if ( has_fpl( ) ) {
                             update_fpl( );
                         }
                     }
@@ -548,19 +500,39 @@ static void ShowMainWindow( bool *p_open ) {
                     
                     if ( ImGui::SliderInt( "J", &vars::uniform::v_j, 1, 50 ) ) {
                         // Update FPL only if we already drew it
-                        if ( !globals::g_fpl.empty( ) ) {
+                        if ( has_fpl( ) ) {
                             update_fpl( );
                         }
                     }
 
                     if ( ImGui::SliderFloat( "Sj", &vars::uniform::v_sj, 0.01f, 0.1f ) ) {
                         // Update FPL only if we already drew it
-                        if ( !globals::g_fpl.empty( ) ) {
+                        if ( has_fpl( ) ) {
                             update_fpl( );
                         }
                     }
                 }
 
+                ImGui::Separator( );
+
+                // Seed of the generator
+                if ( ImGui::InputScalar( "Seed", ImGuiDataType_U64, &vars::v_seed ) ) {
+                    // Update FPL only if we already drew it
+                    if ( has_fpl( ) ) {
+                        update_fpl( );
+                    }
+                }
+
+                if ( ImGui::Button( "New seed", ImVec2( bt_sz_x, bt_sz_y ) ) ) {
+                    std::random_device rd {};
+                    vars::v_seed = ( static_cast< uint64_t >( rd( ) ) << 32 ) | rd( );
+
+                    // Update FPL only if we already drew it
+                    if ( has_fpl( ) ) {
+                        update_fpl( );
+                    }
+                }
+
                 ImGui::Separator( );
                 ImGui::Text( "For charts" );
                 ImGui::Separator( );
@@ -568,11 +540,31 @@ static void ShowMainWindow( bool *p_open ) {
                 // Min delta
                 if ( ImGui::SliderInt( "N", &vars::v_n, 1, 50 ) ) {
                     // Update FPL only if we already drew it
-                    if ( !globals::g_fpl.empty( ) ) {
+                    if ( has_fpl( ) ) {
                         update_fpl( );
                     }
                 }
 
+                // Adaptive N: more realisations where the stats vary more
+                bool adaptive_changed = ImGui::Checkbox( "Adaptive N", &vars::v_adaptive );
+                if ( vars::v_adaptive ) {
+                    adaptive_changed |= ImGui::SliderInt( "Max N", &vars::v_n_max, 50, 5000, "%d", ImGuiSliderFlags_Logarithmic );
+                    adaptive_changed |= ImGui::SliderFloat( "CI tolerance", &vars::v_tol, 0.005f, 0.2f, "%.3f", ImGuiSliderFlags_Logarithmic );
+                }
+
+                // Smoother charts for the same N, the offsets are drawn once per realisation
+                adaptive_changed |= ImGui::Checkbox( "Common random numbers", &vars::v_crn );
+
+                if ( adaptive_changed && has_fpl( ) ) {
+                    update_fpl( );
+                }
+
+                ImGui::Checkbox( "CI bands", &vars::v_ci_bands );
+
+                ImGui::Separator( );
+
+                ImGui::Checkbox( "Thin lines for big FPL's", &vars::v_thin_lines );
+
                 ImGui::EndChild( );
             }
 
@@ -581,7 +573,7 @@ static void ShowMainWindow( bool *p_open ) {
                 const ImU32 main_line_color_u32 = ImColor( 255, 255, 102, 255 );
                 const ImU32 new_line_color_u32 = ImColor( 255, 179, 102, 255 );
 
-                ImGui::Text( "Mouse Left: click to add point" );
+                ImGui::Text( "Mouse Left: click to add a point, drag a point to move it. Mouse Right: delete a point" );
 
                 // Using InvisibleButton() as a convenience 1) it will advance the layout cursor and 2) allows us to use IsItemHovered()/IsItemActive()
                 ImVec2 canvas_p0 = ImGui::GetCursorScreenPos( );      // ImDrawList API uses screen coordinates!
@@ -603,8 +595,42 @@ static void ShowMainWindow( bool *p_open ) {
                 const vec2 origin( canvas_p0.x, canvas_p0.y ); // Lock scrolled origin
                 const vec2 mouse_pos_in_canvas( io.MousePos.x - origin.x, io.MousePos.y - origin.y );
 
-                // Add first and second point
+                // Points being dragged: the vertex under the mouse with every copy of it, moved: since the click
+                static std::vector<size_t> dragged;
+                static vec2 grab_offset;
+                static bool drag_moved = false;
+                const float pick_radius = 6.f;
+
+                // Only the segments on the changed points are made again (see fpl::fpl_tree)
+                bool points_changed = false;
+
                 if ( is_hovered && ImGui::IsMouseClicked( ImGuiMouseButton_Left ) ) {
+                    const auto hit = pick_point( mouse_pos_in_canvas, pick_radius );
+                    if ( hit >= 0 ) {
+                        dragged = points_at( globals::g_points[ hit ] );
+                        grab_offset = globals::g_points[ hit ] - mouse_pos_in_canvas;
+                    }
+                }
+
+                if ( !dragged.empty( ) ) {
+                    if ( !ImGui::IsMouseDown( ImGuiMouseButton_Left ) ) {
+                        dragged.clear( );
+
+                        // Released: the cache and the charts of where it stopped (the FPL is there already)
+                        points_changed = drag_moved;
+                        drag_moved = false;
+                    }
+                    else if ( globals::g_points[ dragged[ 0 ] ] != mouse_pos_in_canvas + grab_offset ) {
+                        for ( const auto n : dragged ) {
+                            globals::g_points[ n ] = mouse_pos_in_canvas + grab_offset;
+                        }
+
+                        points_changed = true;
+                        drag_moved = true;
+                    }
+                }
+                // Add first and second point
+                else if ( is_hovered && ImGui::IsMouseClicked( ImGuiMouseButton_Left ) ) {
                     vec2 prev_b;
 
                     if ( globals::g_points.size() > 1 ) {
@@ -619,6 +645,28 @@ static void ShowMainWindow( bool *p_open ) {
 
                     // Point b
                     globals::g_points.push_back( mouse_pos_in_canvas );
+                    points_changed = true;
+                }
+
+                if ( is_hovered && dragged.empty( ) && ImGui::IsMouseClicked( ImGuiMouseButton_Right ) ) {
+                    const auto hit = pick_point( mouse_pos_in_canvas, pick_radius );
+                    if ( hit >= 0 ) {
+                        remove_point( hit );
+                        points_changed = true;
+                    }
+                }
+
+                // Update FPL only if we already drew it
+                if ( points_changed && has_fpl( ) ) {
+                    if ( globals::g_points.size( ) < 2 ) {
+                        cancel_fpl( );
+                        globals::g_fpl.clear( );
+                        ++globals::g_fpl_rev;
+                        clear_plots( );
+                    }
+                    else {
+                        update_fpl( !dragged.empty( ) );
+                    }
                 }
 
                 // Draw grid + all lines in the canvas
@@ -641,12 +689,23 @@ static void ShowMainWindow( bool *p_open ) {
                 }
 
                 // Drawing FPL's lines
+                // Clipped + decimated to the canvas pixels, cached until g_fpl or the view changes
                 if ( globals::g_fpl.size( ) > 1 ) {
-                    for ( size_t n = 0; n < globals::g_fpl.size( ) - 1; ++n )
-                        if ( globals::g_fpl.size( ) > n + 1 ) {
-                            draw_list->AddLine( ImVec2( origin.x + globals::g_fpl[ n ].x, origin.y + globals::g_fpl[ n ].y ),
-                                                ImVec2( origin.x + globals::g_fpl[ n + 1 ].x, origin.y + globals::g_fpl[ n + 1 ].y ), new_line_color_u32, 2.0f );
+                    static render::lod_cache fpl_lod;
+                    fpl_lod.update( globals::g_fpl, globals::g_fpl_rev, canvas_p0, 1.f, canvas_p0, canvas_p1 );
+
+                    const auto &fpl_screen = fpl_lod.points( );
+                    // By the size of the FPL itself: the decimated one stays within a few points per column
+                    const bool thin = vars::v_thin_lines && globals::g_fpl.size( ) >= render::thin_line_threshold;
+
+                    for ( const auto &piece : fpl_lod.pieces( ) ) {
+                        if ( thin ) {
+                            render::draw_thin_polyline( draw_list, fpl_screen.Data + piece.first, piece.count, new_line_color_u32 );
                         }
+                        else {
+                            render::draw_polyline( draw_list, fpl_screen.Data + piece.first, piece.count, new_line_color_u32, 2.0f );
+                        }
+                    }
                 }
 
                 // Drawing circle on dots
@@ -676,20 +735,34 @@ static void ShowMainWindow( bool *p_open ) {
                         ImGui::Text( "Main lines coordinates: a(x,y) b(x,y)" );
                         ImGui::Separator( );
                         ImGui::Text( "Count of the lines: %d", globals::g_points.size( ) / 2 );
-                        if ( ImGui::BeginListBox( "##MainLinesCoords" ) ) {
-                            for ( size_t i = 0; i < globals::g_points.size( ); i += 2 ) {
-                                // Point a
-                                ImGui::Text( "(%.f, %.f)", globals::g_points[ i ].x, globals::g_points[ i ].y );
-
-                                // Point b
-                                if ( globals::g_points.size( ) > i + 1 ) {
-                                    ImGui::SameLine( );
-                                    ImGui::Text( "(%.f, %.f)", globals::g_points[ i + 1 ].x, globals::g_points[ i + 1 ].y );
-                                }
-                            }
 
-                            ImGui::EndListBox( );
+                        static int lines_goto = 0;
+                        static int lines_jump = -1;
+                        static int lines_sel = -1;
+
+                        const auto lines_rows = static_cast< int >( ( globals::g_points.size( ) + 1 ) / 2 );
+
+                        // Jump to a line by index
+                        ImGui::SetNextItemWidth( 100.f );
+                        ImGui::InputInt( "##MainLinesGoto", &lines_goto );
+                        ImGui::SameLine( );
+                        if ( ImGui::Button( "Go##MainLines" ) && lines_rows > 0 ) {
+                            lines_sel = lines_jump = std::clamp( lines_goto, 0, lines_rows - 1 );
                         }
+
+                        coords_list_box( "##MainLinesCoords", lines_rows, lines_jump, [ & ]( int row ) {
+                            const auto i = static_cast< size_t >( row ) * 2;
+                            const auto col = row == lines_sel ? ImVec4( 1.f, 0.7f, 0.4f, 1.f ) : ImGui::GetStyleColorVec4( ImGuiCol_Text );
+
+                            // Point a
+                            ImGui::TextColored( col, "%d: (%.f, %.f)", row, globals::g_points[ i ].x, globals::g_points[ i ].y );
+
+                            // Point b
+                            if ( globals::g_points.size( ) > i + 1 ) {
+                                ImGui::SameLine( );
+                                ImGui::TextColored( col, "(%.f, %.f)", globals::g_points[ i + 1 ].x, globals::g_points[ i + 1 ].y );
+                            }
+                        } );
                     }
 
                     // Second column -> fpl lines coords
@@ -702,19 +775,43 @@ static void ShowMainWindow( bool *p_open ) {
                         ImGui::Text( "FPL's coordinates: a(x,y) b(x,y)" );
                         ImGui::Separator( );
                         ImGui::Text( "Count of the lines: %d", fpl_size );
-                        if ( ImGui::BeginListBox( "##FPLCoords" ) ) {
-                            for ( size_t i = 0; i < fpl_size; ++i ) {
-                                // Point a
-                                ImGui::Text( "(%.f, %.f)", globals::g_fpl[ i ].x, globals::g_fpl[ i ].y );
 
-                                ImGui::SameLine( );
+                        static int fpl_goto = 0;
+                        static int fpl_jump = -1;
+                        static int fpl_sel = -1;
+                        static float fpl_find[ 2 ] = {};
 
-                                // Point b
-                                ImGui::Text( "(%.f, %.f)", globals::g_fpl[ i + 1 ].x, globals::g_fpl[ i + 1 ].y );
-                            }
+                        const auto fpl_rows = static_cast< int >( fpl_size );
+
+                        // Jump to a line by index
+                        ImGui::SetNextItemWidth( 100.f );
+                        ImGui::InputInt( "##FPLGoto", &fpl_goto );
+                        ImGui::SameLine( );
+                        if ( ImGui::Button( "Go##FPL" ) && fpl_rows > 0 ) {
+                            fpl_sel = fpl_jump = std::clamp( fpl_goto, 0, fpl_rows - 1 );
+                        }
 
-                            ImGui::EndListBox( );
+                        // Jump to the line starting at the vertex nearest to (x, y)
+                        ImGui::SetNextItemWidth( 100.f );
+                        ImGui::InputFloat2( "##FPLFind", fpl_find, "%.f" );
+                        ImGui::SameLine( );
+                        if ( ImGui::Button( "Find##FPL" ) && fpl_rows > 0 ) {
+                            const auto n = find_nearest( globals::g_fpl, vec2( fpl_find[ 0 ], fpl_find[ 1 ] ) );
+                            fpl_goto = fpl_sel = fpl_jump = std::min( n, fpl_rows - 1 );
                         }
+
+                        coords_list_box( "##FPLCoords", fpl_rows, fpl_jump, [ & ]( int row ) {
+                            const auto i = static_cast< size_t >( row );
+                            const auto col = row == fpl_sel ? ImVec4( 1.f, 0.7f, 0.4f, 1.f ) : ImGui::GetStyleColorVec4( ImGuiCol_Text );
+
+                            // Point a
+                            ImGui::TextColored( col, "%d: (%.f, %.f)", row, globals::g_fpl[ i ].x, globals::g_fpl[ i ].y );
+
+                            ImGui::SameLine( );
+
+                            // Point b
+                            ImGui::TextColored( col, "(%.f, %.f)", globals::g_fpl[ i + 1 ].x, globals::g_fpl[ i + 1 ].y );
+                        } );
                     }
 
                     ImGui::EndTable( );
@@ -725,9 +822,27 @@ static void ShowMainWindow( bool *p_open ) {
                 if ( ImPlot::BeginPlot( "Line Plot 1" ) ) {
                     ImPlot::SetupAxes( "s", "value", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit );
 
-                    ImPlot::PlotLine( "max", plots::ar_x, plots::ar_max, plots::pl_x.size( ) );
-                    ImPlot::PlotLine( "mean", plots::ar_x, plots::ar_mean, plots::pl_x.size( ) );
-                    ImPlot::PlotLine( "elong", plots::ar_x, plots::ar_elong, plots::pl_x.size( ) );
+                    const auto &series = plots::g_series;
+                    const auto count = static_cast< int >( series.x.size( ) );
+
+                    // Same label -> same legend item and color as the line
+                    if ( vars::v_ci_bands ) {
+                        ImPlot::SetNextFillStyle( IMPLOT_AUTO_COL, 0.25f );
+                        ImPlot::PlotShaded( "max", series.x.data( ), plots::g_max.lo.data( ), plots::g_max.hi.data( ), count );
+                    }
+                    ImPlot::PlotLine( "max", series.x.data( ), series.max.data( ), count );
+
+                    if ( vars::v_ci_bands ) {
+                        ImPlot::SetNextFillStyle( IMPLOT_AUTO_COL, 0.25f );
+                        ImPlot::PlotShaded( "mean", series.x.data( ), plots::g_mean.lo.data( ), plots::g_mean.hi.data( ), count );
+                    }
+                    ImPlot::PlotLine( "mean", series.x.data( ), series.mean.data( ), count );
+
+                    if ( vars::v_ci_bands ) {
+                        ImPlot::SetNextFillStyle( IMPLOT_AUTO_COL, 0.25f );
+                        ImPlot::PlotShaded( "elong", series.x.data( ), plots::g_elong.lo.data( ), plots::g_elong.hi.data( ), count );
+                    }
+                    ImPlot::PlotLine( "elong", series.x.data( ), series.elong.data( ), count );
 
                     ImPlot::EndPlot( );
                 }
@@ -746,7 +861,14 @@ static void ShowMainWindow( bool *p_open ) {
                                 ImPlot::SetupAxes( "s", "value", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit );
                             }
 
-                            ImPlot::PlotLine( ss.str().c_str(), plots::ar_x, plots::ar_log2elong, plots::pl_x.size( ) );
+                            const auto &series = plots::g_series;
+                            const auto count = static_cast< int >( series.x.size( ) );
+
+                            if ( vars::v_ci_bands ) {
+                                ImPlot::SetNextFillStyle( IMPLOT_AUTO_COL, 0.25f );
+                                ImPlot::PlotShaded( ss.str( ).c_str( ), series.x.data( ), plots::g_log2elong.lo.data( ), plots::g_log2elong.hi.data( ), count );
+                            }
+                            ImPlot::PlotLine( ss.str( ).c_str( ), series.x.data( ), series.log2elong.data( ), count );
 
                             ImPlot::EndPlot( );
                         }
@@ -766,7 +888,22 @@ static void ShowMainWindow( bool *p_open ) {
                         if ( ImPlot::BeginPlot( "Line Plot 3" ) ) {
                             ImPlot::SetupAxes( "r", "value", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit );
 
-                            ImPlot::PlotLine( ss.str( ).c_str( ), plots::ar3_x, plots::ar3_log2elong, plots::pl3_x.size( ) );
+                            // r is int, the values are float -> through getters
+                            if ( vars::v_ci_bands ) {
+                                ImPlot::SetNextFillStyle( IMPLOT_AUTO_COL, 0.25f );
+                                ImPlot::PlotShadedG( ss.str( ).c_str( ), [ ]( int idx, void *data ) {
+                                    const auto &series = *static_cast< const fpl::series * >( data );
+                                    return ImPlotPoint( series.x3[ idx ], series.log2elong3[ idx ] - series.log2elong3_ci[ idx ] );
+                                }, &plots::g_series, [ ]( int idx, void *data ) {
+                                    const auto &series = *static_cast< const fpl::series * >( data );
+                                    return ImPlotPoint( series.x3[ idx ], series.log2elong3[ idx ] + series.log2elong3_ci[ idx ] );
+                                }, &plots::g_series, static_cast< int >( plots::g_series.x3.size( ) ) );
+                            }
+
+                            ImPlot::PlotLineG( ss.str( ).c_str( ), [ ]( int idx, void *data ) {
+                                const auto &series = *static_cast< const fpl::series * >( data );
+                                return ImPlotPoint( series.x3[ idx ], series.log2elong3[ idx ] );
+                            }, &plots::g_series, static_cast< int >( plots::g_series.x3.size( ) ) );
 
                             ImPlot::EndPlot( );
                         }
@@ -884,6 +1021,9 @@ int main( int, char ** ) {
             ResetDevice( );
     }
 
+    // No job may touch the pool or the results once main returns
+    jobs::g_worker.stop( );
+
     ImGui_ImplDX9_Shutdown( );
     ImGui_ImplWin32_Shutdown( );
     ImPlot::DestroyContext( );
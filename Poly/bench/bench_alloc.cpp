@@ -0,0 +1,117 @@
+// Heap allocations of the chart sweeps (fpl::get_stats) once they run in steady state: counted by a global
+// operator new, per call and per realisation, for fixed and adaptive N, with and without CRN, the cutoff and the pool
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_alloc.cpp ../fpl/*.cpp -o bench_alloc
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/generator.h"
+#include "../fpl/pool.h"
+#include "../fpl/stats.h"
+
+namespace {
+    std::atomic<size_t> g_allocs { 0 };
+}
+
+void *operator new( size_t size ) {
+    ++g_allocs;
+    if ( auto *p = std::malloc( size ? size : 1 ) ) {
+        return p;
+    }
+
+    throw std::bad_alloc( );
+}
+
+void operator delete( void *p ) noexcept {
+    std::free( p );
+}
+
+void operator delete( void *p, size_t ) noexcept {
+    std::free( p );
+}
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    struct run {
+        const char *name;
+        fpl::settings cfg;
+        unsigned threads;
+    };
+
+    // Realisations of one get_stats: every sweep value and every depth of chart 3 got samples of them
+    size_t realisations( const fpl::series &s ) {
+        size_t ret = 0;
+        for ( const auto n : s.samples ) {
+            ret += static_cast< size_t >( n );
+        }
+        for ( const auto n : s.samples3 ) {
+            ret += static_cast< size_t >( n );
+        }
+
+        return ret;
+    }
+}
+
+int main( ) {
+    const std::vector<vec2> tri { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f }, { 300.f, 500.f }, { 0.f, 0.f } };
+
+    std::vector<run> runs;
+    for ( const unsigned threads : { 1u, 4u } ) {
+        fpl::settings cfg;
+        cfg.r = 8;
+        cfg.delta = 0;
+        cfg.n = 25;
+        runs.push_back( { "fixed N", cfg, threads } );
+
+        cfg.delta = 4;
+        runs.push_back( { "cutoff", cfg, threads } );
+
+        cfg.delta = 0;
+        cfg.adaptive = true;
+        cfg.n = 10;
+        cfg.n_max = 200;
+        runs.push_back( { "adaptive", cfg, threads } );
+
+        cfg.crn = true;
+        runs.push_back( { "adaptive crn", cfg, threads } );
+    }
+
+    bool ok = true;
+    std::printf( "%14s %8s %14s %14s %16s %10s\n", "sweep", "threads", "realisations", "allocs/call", "allocs/realis.", "ms/call" );
+
+    for ( const auto &r : runs ) {
+        fpl::pool workers( r.threads );
+        fpl::series out;
+
+        // Warm up: thread-local scratch, the pool and the result buffers grow to their size
+        // get_stats appends to out, the GUI and the CLI clear it first
+        for ( int c = 0; c < 2; ++c ) {
+            out.clear( );
+            fpl::get_stats( tri, r.cfg, out, workers );
+        }
+
+        constexpr int calls = 5;
+        const auto before = g_allocs.load( );
+        const auto start = clock_type::now( );
+        for ( int c = 0; c < calls; ++c ) {
+            out.clear( );
+            fpl::get_stats( tri, r.cfg, out, workers );
+        }
+        const auto sec = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+
+        const auto allocs = static_cast< double >( g_allocs.load( ) - before ) / calls;
+        const auto count = realisations( out );
+        std::printf( "%14s %8u %14zu %14.1f %16.4f %10.2f\n", r.name, r.threads, count, allocs, allocs / count, sec / calls * 1e3 );
+
+        ok = ok && allocs == 0.0;
+    }
+
+    // Every temporary is in the arenas of the threads by now
+    std::printf( "\nno heap allocations in steady state: %s\n", ok ? "yes" : "NO" );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// fpl::result_cache: a hit vs making the FPL + charts again, the LRU order under a small budget
+// and a round trip through the cache dir
+// Build: g++ -O2 -std=c++20 -pthread bench_cache.cpp ../fpl/*.cpp -o bench_cache
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/cache.h"
+#include "../fpl/generator.h"
+#include "../fpl/stats.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    template <typename Fn>
+    double sec_of( Fn &&fn ) {
+        const auto start = clock_type::now( );
+        fn( );
+        return std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+    }
+
+    bool same( const fpl::series &a, const fpl::series &b ) {
+        return a.x == b.x && a.max == b.max && a.mean == b.mean && a.elong == b.elong && a.max_ci == b.max_ci && a.samples == b.samples &&
+               a.x3 == b.x3 && a.log2elong3 == b.log2elong3 && a.samples3 == b.samples3;
+    }
+}
+
+int main( ) {
+    const std::vector<vec2> tri { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f }, { 300.f, 500.f }, { 0.f, 0.f } };
+
+    fpl::settings cfg;
+    cfg.r = 12;
+    cfg.delta = 0;
+    cfg.n = 25;
+
+    bool ok = true;
+
+    // A slider going back to a value it had a moment ago
+    fpl::result_cache cache;
+    std::vector<vec2> fpl_points;
+    fpl::series stats;
+
+    const auto make_sec = sec_of( [ & ]( ) {
+        fpl_points = fpl::do_fpl( tri, cfg );
+        fpl::get_stats( tri, cfg, stats );
+        cache.put( fpl::fpl_key( tri, cfg ), fpl_points );
+        cache.put( fpl::stats_key( tri, cfg ), stats );
+    } );
+
+    std::vector<vec2> hit_points;
+    fpl::series hit_stats;
+    const auto hit_sec = sec_of( [ & ]( ) {
+        ok = cache.get( fpl::fpl_key( tri, cfg ), hit_points ) && ok;
+        ok = cache.get( fpl::stats_key( tri, cfg ), hit_stats ) && ok;
+    } );
+
+    ok = ok && hit_points == fpl_points && same( hit_stats, stats );
+    std::printf( "make %.3f ms, hit %.3f ms (%.0fx), %zu bytes kept\n", make_sec * 1e3, hit_sec * 1e3, make_sec / hit_sec, cache.bytes( ) );
+
+    // Keys only change with what the result depends on
+    auto other = cfg;
+    other.n = 50;
+    ok = ok && fpl::fpl_key( tri, other ) == fpl::fpl_key( tri, cfg ) && fpl::stats_key( tri, other ) != fpl::stats_key( tri, cfg );
+    other = cfg;
+    other.stddev = 0.5f;
+    ok = ok && fpl::stats_key( tri, other ) == fpl::stats_key( tri, cfg );
+    other.seed = 2;
+    ok = ok && fpl::fpl_key( tri, other ) != fpl::fpl_key( tri, cfg );
+
+    // Other main lines, one point moved by the least step: never the same key
+    auto moved = tri;
+    moved[ 3 ].x = std::nextafter( moved[ 3 ].x, 1e9f );
+    ok = ok && fpl::fpl_key( moved, cfg ) != fpl::fpl_key( tri, cfg ) && fpl::stats_key( moved, cfg ) != fpl::stats_key( tri, cfg );
+
+    // Room for two FPL's of R = 12: the least recently used one goes
+    const auto fpl_bytes = fpl_points.size( ) * sizeof( vec2 ) + fpl::fpl_key( tri, cfg ).size( );
+    fpl::result_cache small( 2 * fpl_bytes + fpl_bytes / 2 );
+    std::vector<std::string> keys;
+    for ( uint64_t seed = 1; seed <= 3; ++seed ) {
+        other = cfg;
+        other.seed = seed;
+        keys.push_back( fpl::fpl_key( tri, other ) );
+    }
+
+    std::vector<vec2> got;
+    small.put( keys[ 0 ], fpl_points );
+    small.put( keys[ 1 ], fpl_points );
+    small.get( keys[ 0 ], got );
+    small.put( keys[ 2 ], fpl_points );
+
+    const bool lru = small.get( keys[ 0 ], got ) && !small.get( keys[ 1 ], got ) && small.get( keys[ 2 ], got );
+    ok = ok && lru;
+    std::printf( "LRU eviction: %s\n", lru ? "yes" : "NO" );
+
+    // A new cache on the same dir: another run of the CLI
+    const auto dir = ( std::filesystem::temp_directory_path( ) / "fpl_bench_cache" ).string( );
+    std::filesystem::remove_all( dir );
+    {
+        fpl::result_cache disk( 0, dir );
+        disk.put( fpl::fpl_key( tri, cfg ), fpl_points );
+        disk.put( fpl::stats_key( tri, cfg ), stats );
+    }
+
+    fpl::result_cache disk( 0, dir );
+    hit_points.clear( );
+    hit_stats.clear( );
+    const auto disk_sec = sec_of( [ & ]( ) {
+        ok = disk.get( fpl::fpl_key( tri, cfg ), hit_points ) && ok;
+        ok = disk.get( fpl::stats_key( tri, cfg ), hit_stats ) && ok;
+    } );
+
+    const bool disk_same = hit_points == fpl_points && same( hit_stats, stats );
+    ok = ok && disk_same;
+    std::printf( "disk hit %.3f ms, same results: %s\n", disk_sec * 1e3, disk_same ? "yes" : "NO" );
+
+    std::filesystem::remove_all( dir );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+// Counter-based offsets: check that the depth-first, level by level and random access paths give the same points
+// (also for tiles made in parallel), and offsets/second of Philox4x32-10 vs mt19937
+// Build: g++ -O2 -std=c++20 -pthread bench_counter.cpp ../fpl/bfs.cpp ../fpl/pool.cpp -o bench_counter
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/engine.h"
+#include "../fpl/bfs.h"
+#include "../fpl/philox.h"
+#include "../fpl/pool.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Min time spent for one measurement
+    constexpr double min_time_sec = 0.2;
+
+    template <typename Fn>
+    double per_sec( Fn &&fn ) {
+        size_t done = 0;
+        double elapsed = 0.0;
+
+        const auto start = clock_type::now( );
+        do {
+            done += fn( );
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        return done / elapsed;
+    }
+}
+
+int main( ) {
+    const vec2 a( 0.f, 300.f );
+    const vec2 b( 1000.f, 300.f );
+
+    const rng::node_key key { 12345u, 7u, 3u };
+    auto rf = [ & ]( int l, uint64_t k ) { return 0.2f * rng::unit_uniform( key, l, k ); };
+
+    fpl::pool workers;
+    fpl::bfs_buffers buf;
+    std::mt19937 pick { 1u };
+
+    std::printf( "%3s %10s %10s %10s %10s %10s\n", "R", "points", "dfs=bfs", "tiles", "points", "parallel" );
+
+    bool all_same = true;
+    for ( int r = 1; r <= 20; ++r ) {
+        const auto total = fpl::capacity( r );
+
+        // Delta = 0 -> no cutoff, every level is split
+        std::vector<vec2> dfs( total ), bfs( total );
+        fpl::generate( a, b, r, 0, rf, dfs.data( ) );
+        fpl::generate_bfs( a, b, r, rf, bfs.data( ), buf );
+        const bool same_bfs = dfs == bfs;
+
+        // Random tiles
+        bool same_tiles = true;
+        for ( int t = 0; t < 64; ++t ) {
+            const auto first = std::uniform_int_distribution<size_t>( 0, total - 1 )( pick );
+            const auto count = std::uniform_int_distribution<size_t>( 1, total - first )( pick );
+
+            std::vector<vec2> tile( count );
+            const auto written = fpl::generate_range( a, b, r, first, count, rf, tile.data( ) );
+            same_tiles = same_tiles && written == count && std::equal( tile.begin( ), tile.end( ), dfs.begin( ) + first );
+        }
+
+        // Single points
+        bool same_points = true;
+        for ( int t = 0; t < 64; ++t ) {
+            const auto k = std::uniform_int_distribution<size_t>( 0, total - 1 )( pick );
+
+            vec2 point;
+            fpl::generate_range( a, b, r, k, 1, rf, &point );
+            same_points = same_points && point == dfs[ k ];
+        }
+
+        // The whole FPL as tiles made on the pool in any order
+        constexpr size_t tiles = 16;
+        const auto tile_size = ( total + tiles - 1 ) / tiles;
+        std::vector<vec2> par( total );
+        workers.run( tiles, [ & ]( size_t t ) {
+            const auto first = t * tile_size;
+            if ( first < total ) {
+                fpl::generate_range( a, b, r, first, tile_size, rf, par.data( ) + first );
+            }
+        } );
+        const bool same_par = par == dfs;
+
+        all_same = all_same && same_bfs && same_tiles && same_points && same_par;
+
+        std::printf( "%3d %10zu %10s %10s %10s %10s\n", r, total, same_bfs ? "yes" : "NO", same_tiles ? "yes" : "NO",
+                     same_points ? "yes" : "NO", same_par ? "yes" : "NO" );
+    }
+
+    // Offsets/second, the sum keeps the compiler from dropping the work
+    volatile float sink = 0.f;
+
+    std::mt19937 gen { 42u };
+    std::uniform_real_distribution<float> dis { -1.f, 1.f };
+    const auto mt_ops = per_sec( [ & ]( ) {
+        float sum = 0.f;
+        for ( int n = 0; n < 1 << 16; ++n ) {
+            sum += dis( gen );
+        }
+        sink = sink + sum;
+        return size_t( 1 ) << 16;
+    } );
+
+    uint64_t k = 0;
+    const auto philox_ops = per_sec( [ & ]( ) {
+        float sum = 0.f;
+        for ( int n = 0; n < 1 << 16; ++n ) {
+            sum += rng::unit_uniform( key, 20, k++ );
+        }
+        sink = sink + sum;
+        return size_t( 1 ) << 16;
+    } );
+
+    const auto philox_normal_ops = per_sec( [ & ]( ) {
+        float sum = 0.f;
+        for ( int n = 0; n < 1 << 16; ++n ) {
+            sum += rng::unit_normal( key, 20, k++ );
+        }
+        sink = sink + sum;
+        return size_t( 1 ) << 16;
+    } );
+
+    std::printf( "\n%-24s %14s\n", "offsets", "per second" );
+    std::printf( "%-24s %14.0f\n", "mt19937 uniform", mt_ops );
+    std::printf( "%-24s %14.0f\n", "philox uniform", philox_ops );
+    std::printf( "%-24s %14.0f\n", "philox normal", philox_normal_ops );
+
+    return all_same ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Common random numbers: stats made from the cached unit offset tree (scaled) vs fpl::stream_stat drawing them,
+// then get_stats with --crn off / on: time and how noisy the charts are
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_crn.cpp ../fpl/*.cpp -o bench_crn
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/generator.h"
+#include "../fpl/pool.h"
+#include "../fpl/stats.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Min time spent for one measurement
+    constexpr double min_time_sec = 0.5;
+
+    template <typename Fn>
+    double sec_per_run( Fn &&fn ) {
+        size_t runs = 0;
+        double elapsed = 0.0;
+
+        const auto start = clock_type::now( );
+        do {
+            fn( );
+            ++runs;
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        return elapsed / runs;
+    }
+
+    // RMS of the second differences of a chart: its noise, what's left without the trend
+    double roughness( const std::vector<float> &y ) {
+        if ( y.size( ) < 3 ) {
+            return 0.0;
+        }
+
+        double sum = 0.0;
+        for ( size_t v = 1; v + 1 < y.size( ); ++v ) {
+            const double d = y[ v + 1 ] - 2.0 * y[ v ] + y[ v - 1 ];
+            sum += d * d;
+        }
+
+        return std::sqrt( sum / ( y.size( ) - 2 ) );
+    }
+
+    bool same( const fpl::series &a, const fpl::series &b ) {
+        return a.x == b.x && a.max == b.max && a.mean == b.mean && a.elong == b.elong && a.samples == b.samples &&
+               a.log2elong3 == b.log2elong3 && a.samples3 == b.samples3;
+    }
+
+    struct shape {
+        const char *name;
+        std::vector<vec2> points;
+        int delta;
+    };
+}
+
+int main( ) {
+    // Main lines as pairs (a, b)
+    const std::vector<shape> shapes {
+        { "segment", { { 0.f, 300.f }, { 1000.f, 300.f } }, 0 },
+        { "triangle", { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f }, { 300.f, 500.f }, { 0.f, 0.f } }, 0 },
+        { "cutoff", { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f } }, 2 },
+    };
+
+    // One 16 deep tree per realisation serves every scale and every R up to 16
+    bool all_same = true;
+    for ( const auto &sh : shapes ) {
+        for ( int gen_type = fpl::gen_normal; gen_type <= fpl::gen_uniform; ++gen_type ) {
+            for ( uint64_t stream = 1; stream <= 3; ++stream ) {
+                fpl::unit_tree tree;
+                tree.fill( gen_type, 7u, stream, sh.points, 16 );
+
+                for ( int r = 0; r <= 16; ++r ) {
+                    for ( const float scale : { 0.01f, 0.2f, 0.37f } ) {
+                        const auto ref = fpl::stream_stat( sh.points, r, sh.delta, gen_type, scale, scale, 7u, stream );
+                        const auto got = fpl::stream_stat( sh.points, r, sh.delta, scale, tree );
+
+                        if ( got != ref ) {
+                            std::printf( "differs: %s, gen %d, R %d, scale %g, stream %llu\n", sh.name, gen_type, r, scale,
+                                         static_cast< unsigned long long >( stream ) );
+                            all_same = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf( "unit tree * scale == stream_stat: %s\n\n", all_same ? "yes" : "NO" );
+
+    // The sweeps of the app for the triangle
+    const auto &tri = shapes[ 1 ].points;
+    fpl::pool one( 1 );
+
+    std::printf( "%-8s %3s %5s %12s %12s %14s %14s\n", "gen", "R", "crn", "sweep ms", "speedup", "noise elong", "noise chart3" );
+    for ( int gen_type = fpl::gen_normal; gen_type <= fpl::gen_uniform; ++gen_type ) {
+        for ( const int r : { 8, 12 } ) {
+            double off_sec = 0.0;
+
+            for ( const bool crn : { false, true } ) {
+                fpl::settings cfg;
+                cfg.r = r;
+                cfg.delta = 0;
+                cfg.n = 25;
+                cfg.gen_type = gen_type;
+                cfg.crn = crn;
+
+                fpl::series out;
+                const auto sec = sec_per_run( [ & ]( ) {
+                    out.clear( );
+                    fpl::get_stats( tri, cfg, out );
+                } );
+
+                // No matter the threads
+                fpl::series out1;
+                fpl::get_stats( tri, cfg, out1, one );
+                all_same = all_same && same( out, out1 );
+
+                if ( !crn ) {
+                    off_sec = sec;
+                }
+
+                std::printf( "%-8s %3d %5s %12.2f %11.2fx %14.5f %14.5f%s\n", gen_type == fpl::gen_normal ? "normal" : "uniform", r, crn ? "on" : "off",
+                             sec * 1e3, off_sec / sec, roughness( out.elong ), roughness( out.log2elong3 ), same( out, out1 ) ? "" : " (threads differ)" );
+            }
+        }
+    }
+
+    return all_same ? 0 : 1;
+}
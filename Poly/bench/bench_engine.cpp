@@ -0,0 +1,145 @@
+// Points/second of the old recursive FPLrec vs fpl::generate (depth-first) vs fpl::generate_bfs (level by level)
+// for R = 1..22, and a check that both engines give the same points for the same offsets
+// Build: g++ -O2 -std=c++20 [-mavx2] bench_engine.cpp ../fpl/bfs.cpp -o bench_engine
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/engine.h"
+#include "../fpl/bfs.h"
+
+namespace legacy {
+    // Old FPLrec from Poly.cpp, kept only as the reference for this benchmark
+    template <typename Rf>
+    std::vector<vec2> FPLrec( std::vector<vec2> list_a, vec2 point_b, int r, int delta, Rf &rf ) {
+        auto vec_a = list_a.back( );
+        auto vec_b = point_b;
+
+        // Getting the length of the segment ab
+        auto vec_v = vec_b - vec_a;
+        auto v_len = vec_v.length( );
+
+        // Recursion stop condition
+        if ( r == 0 || v_len < delta ) {
+            list_a.push_back( vec_b );
+            return list_a;
+        }
+
+        // Middle point
+        auto c = ( vec_a + vec_b ) / 2;
+
+        // Middle points offset
+        auto rotv = vec_v.rotate( 90.f );
+        auto rf_v = rf( );
+        auto d = vec2( c.x + rf_v * rotv.x, c.y + rf_v * rotv.y );
+
+        // Splitting the segment ad
+        list_a = FPLrec( list_a, d, --r, delta, rf );
+
+        // Splitting the segment ab
+        return FPLrec( list_a, vec_b, r, delta, rf );
+    }
+}
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Stop measuring the legacy path once one run takes longer than this
+    constexpr double legacy_limit_sec = 2.0;
+
+    // Min time spent for one measurement
+    constexpr double min_time_sec = 0.2;
+
+    // Both paths get the same cheap offsets so only the engine cost is measured
+    struct bench_rf {
+        std::mt19937 gen { 42u };
+        std::uniform_real_distribution<float> dis { -0.3f, 0.3f };
+
+        float operator()( ) {
+            return dis( gen );
+        }
+    };
+
+    template <typename Fn>
+    double points_per_sec( Fn &&fn, double *run_sec = nullptr ) {
+        size_t points = 0;
+        size_t runs = 0;
+        double elapsed = 0.0;
+
+        const auto start = clock_type::now( );
+        do {
+            points += fn( );
+            ++runs;
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        if ( run_sec ) {
+            *run_sec = elapsed / runs;
+        }
+
+        return points / elapsed;
+    }
+}
+
+int main( ) {
+    const vec2 a( 0.f, 300.f );
+    const vec2 b( 1000.f, 300.f );
+
+    // Delta = 0 -> no cutoff, every level is split
+    const int delta = 0;
+
+    std::printf( "%3s %10s %14s %14s %14s %8s %10s\n", "R", "points", "legacy pts/s", "dfs pts/s", "bfs pts/s", "bfs/dfs", "identical" );
+
+    bool legacy_enabled = true;
+    bool all_same = true;
+    std::vector<vec2> out;
+    std::vector<vec2> out_bfs;
+    fpl::bfs_buffers buf;
+
+    for ( int r = 1; r <= 22; ++r ) {
+        out.resize( fpl::capacity( r ) );
+        out_bfs.resize( fpl::capacity( r ) );
+
+        bench_rf rf_engine;
+        size_t count = 0;
+        const auto engine_pps = points_per_sec( [ & ]( ) {
+            count = fpl::generate( a, b, r, delta, rf_engine, out.data( ) );
+            return count;
+        } );
+
+        bench_rf rf_bfs;
+        const auto bfs_pps = points_per_sec( [ & ]( ) {
+            return fpl::generate_bfs( a, b, r, rf_bfs, out_bfs.data( ), buf );
+        } );
+
+        // Same offsets for both, compared bit for bit
+        bench_rf rf_check_dfs, rf_check_bfs;
+        fpl::generate( a, b, r, delta, rf_check_dfs, out.data( ) );
+        fpl::generate_bfs( a, b, r, rf_check_bfs, out_bfs.data( ), buf );
+        const bool same = out == out_bfs;
+        all_same = all_same && same;
+
+        double legacy_pps = 0.0;
+        if ( legacy_enabled ) {
+            bench_rf rf_legacy;
+            double run_sec = 0.0;
+            legacy_pps = points_per_sec( [ & ]( ) {
+                std::vector<vec2> list_a { a };
+                return legacy::FPLrec( list_a, b, r, delta, rf_legacy ).size( );
+            }, &run_sec );
+
+            legacy_enabled = run_sec < legacy_limit_sec;
+        }
+
+        char legacy_str[ 32 ] = "skipped";
+        if ( legacy_pps > 0.0 ) {
+            std::snprintf( legacy_str, sizeof( legacy_str ), "%.0f", legacy_pps );
+        }
+
+        std::printf( "%3d %10zu %14s %14.0f %14.0f %7.2fx %10s\n", r, count, legacy_str, engine_pps, bfs_pps, bfs_pps / engine_pps, same ? "yes" : "NO" );
+    }
+
+    return all_same ? 0 : 1;
+}
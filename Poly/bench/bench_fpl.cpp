@@ -0,0 +1,155 @@
+// do_fpl of polygons with thousands of edges over the thread count (every main segment in its own slot, then packed),
+// checked against the serial loop it replaced, and fpl_tree made in parallel against do_fpl
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_fpl.cpp ../fpl/*.cpp -o bench_fpl
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/bfs.h"
+#include "../fpl/engine.h"
+#include "../fpl/generator.h"
+#include "../fpl/pool.h"
+#include "../fpl/tree.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Regular polygon as pairs (a, b), one per edge
+    std::vector<vec2> polygon( size_t sides ) {
+        std::vector<vec2> points;
+        for ( size_t v = 0; v < sides; ++v ) {
+            const auto angle = 2.f * M_PI * v / sides;
+            const auto next = 2.f * M_PI * ( v + 1 ) / sides;
+            points.emplace_back( 1000.f + 900.f * std::cos( angle ), 1000.f + 900.f * std::sin( angle ) );
+            points.emplace_back( 1000.f + 900.f * std::cos( next ), 1000.f + 900.f * std::sin( next ) );
+        }
+
+        return points;
+    }
+
+    // The serial do_fpl: segments one after another, compacted into the growing FPL
+    std::vector<vec2> serial_fpl( const std::vector<vec2> &points, const fpl::settings &cfg, std::vector<size_t> &ends ) {
+        std::vector<vec2> out;
+        ends.clear( );
+
+        fpl::bfs_buffers bfs;
+        const fpl::main_index mains( points );
+        for ( size_t i = 0; i + 1 < points.size( ); i += 2 ) {
+            const fpl::segment_rf rf { cfg.gen_type, cfg.stddev, cfg.s( ), { cfg.seed, 0, fpl::segment_id( points[ i ], points[ i + 1 ] ) } };
+
+            const auto base = out.size( );
+            out.resize( base + fpl::capacity( cfg.r ) );
+            const auto count = fpl::no_cutoff( points[ i ], points[ i + 1 ], cfg.r, cfg.delta )
+                ? fpl::generate_bfs( points[ i ], points[ i + 1 ], cfg.r, rf, out.data( ) + base, bfs )
+                : fpl::generate( points[ i ], points[ i + 1 ], cfg.r, cfg.delta, rf, out.data( ) + base );
+
+            auto dst = base;
+            for ( size_t n = 0; n < count; ++n ) {
+                const auto point = out[ base + n ];
+                if ( n + 1 < count && ( ( dst > 0 && out[ dst - 1 ] == point ) || mains.is_link( point, out[ base + n + 1 ] ) ) ) {
+                    continue;
+                }
+
+                out[ dst++ ] = point;
+            }
+
+            out.resize( dst );
+            ends.push_back( dst - 1 );
+        }
+
+        return out;
+    }
+
+    template <typename Fn>
+    double best_sec( Fn &&fn ) {
+        double best = 1e30;
+        for ( int run = 0; run < 3; ++run ) {
+            const auto start = clock_type::now( );
+            fn( );
+            const auto sec = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+            best = sec < best ? sec : best;
+        }
+
+        return best;
+    }
+}
+
+// Usage: bench_fpl [max threads], hardware threads by default
+int main( int argc, char **argv ) {
+    unsigned max_threads = argc > 1 ? static_cast< unsigned >( std::atoi( argv[ 1 ] ) ) : std::thread::hardware_concurrency( );
+    if ( max_threads == 0 ) {
+        max_threads = 1;
+    }
+
+    // Same FPL as the serial loop: both generators, with and without the cutoff, in one thread and in many
+    bool all_same = true;
+    fpl::pool many( max_threads > 1 ? max_threads : 4 );
+
+    for ( const size_t sides : { size_t( 3 ), size_t( 100 ) } ) {
+        const auto points = polygon( sides );
+
+        for ( int gen_type = fpl::gen_normal; gen_type <= fpl::gen_uniform; ++gen_type ) {
+            for ( const int delta : { 0, 40 } ) {
+                for ( int r = 0; r <= 10; r += 2 ) {
+                    fpl::settings cfg;
+                    cfg.r = r;
+                    cfg.delta = delta;
+                    cfg.gen_type = gen_type;
+
+                    std::vector<size_t> ref_ends, ends;
+                    const auto ref = serial_fpl( points, cfg, ref_ends );
+                    const auto got = fpl::do_fpl( points, r, delta, gen_type, cfg.stddev, cfg.s( ), cfg.seed, 0, &ends, &many );
+
+                    fpl::fpl_tree tree;
+                    tree.reset( points, cfg );
+                    tree.set_depth( r, &many );
+
+                    std::vector<size_t> tree_ends;
+                    const auto tree_fpl = tree.polyline( &tree_ends, &many );
+
+                    if ( got != ref || ends != ref_ends || tree_fpl != ref || tree_ends != ref_ends ) {
+                        std::printf( "differs: %zu sides, gen %d, delta %d, R %d\n", sides, gen_type, delta, r );
+                        all_same = false;
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf( "parallel do_fpl and fpl_tree == serial do_fpl: %s\n\n", all_same ? "yes" : "NO" );
+
+    // 1, 2, 4... and the max itself
+    std::vector<unsigned> counts;
+    for ( unsigned t = 1; t < max_threads; t *= 2 ) {
+        counts.push_back( t );
+    }
+    counts.push_back( max_threads );
+
+    fpl::settings cfg;
+    cfg.r = 8;
+    cfg.delta = 0;
+
+    const auto points = polygon( 4096 );
+    std::vector<size_t> ends;
+    std::vector<vec2> ref;
+    const auto serial_sec = best_sec( [ & ]( ) { ref = serial_fpl( points, cfg, ends ); } );
+
+    std::printf( "polygon of %zu edges, R %d, %zu points: serial loop %.2f ms\n", points.size( ) / 2, cfg.r, ref.size( ), serial_sec * 1e3 );
+    std::printf( "%8s %12s %10s %11s %10s\n", "threads", "time, ms", "speedup", "efficiency", "identical" );
+
+    for ( const auto threads : counts ) {
+        fpl::pool workers( threads );
+
+        std::vector<vec2> got;
+        const auto sec = best_sec( [ & ]( ) { got = fpl::do_fpl( points, cfg, &workers ); } );
+
+        all_same = all_same && got == ref;
+        std::printf( "%8u %12.2f %9.2fx %10.0f%% %10s\n", threads, sec * 1e3, serial_sec / sec, 100.0 * serial_sec / sec / threads, got == ref ? "yes" : "NO" );
+    }
+
+    return all_same ? 0 : 1;
+}
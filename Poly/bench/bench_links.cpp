@@ -0,0 +1,107 @@
+// Main link lookup of the FPL compaction: is_main_link (std::find over the main points, O( points ) per FPL point)
+// vs fpl::main_index (hash of the main points, O( 1 )), do_fpl of polygons up to 10k edges
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_links.cpp ../fpl/*.cpp -o bench_links
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/engine.h"
+#include "../fpl/generator.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    template <typename Fn>
+    double sec_of( Fn &&fn ) {
+        const auto start = clock_type::now( );
+        fn( );
+        return std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+    }
+
+    // Regular polygon as pairs (a, b), one per edge
+    std::vector<vec2> polygon( size_t sides ) {
+        std::vector<vec2> points;
+        for ( size_t v = 0; v < sides; ++v ) {
+            const auto angle = 2.f * M_PI * v / sides;
+            const auto next = 2.f * M_PI * ( v + 1 ) / sides;
+            points.emplace_back( 1000.f + 900.f * std::cos( angle ), 1000.f + 900.f * std::sin( angle ) );
+            points.emplace_back( 1000.f + 900.f * std::cos( next ), 1000.f + 900.f * std::sin( next ) );
+        }
+
+        return points;
+    }
+
+    // do_fpl's compaction with the linear lookup, over an FPL made with the cutoff off (every point kept)
+    std::vector<vec2> compact_linear( const std::vector<vec2> &points, const std::vector<vec2> &raw, size_t per_segment ) {
+        std::vector<vec2> out;
+        out.reserve( raw.size( ) );
+
+        for ( size_t base = 0; base < raw.size( ); base += per_segment ) {
+            for ( size_t n = 0; n < per_segment; ++n ) {
+                const auto &point = raw[ base + n ];
+                if ( n + 1 < per_segment && ( ( !out.empty( ) && out.back( ) == point ) || fpl::is_main_link( points, point, raw[ base + n + 1 ] ) ) ) {
+                    continue;
+                }
+
+                out.push_back( point );
+            }
+        }
+
+        return out;
+    }
+}
+
+int main( ) {
+    // Every main point looked up the same both ways, repeats, -0 and the points after the last one too
+    const std::vector<vec2> tricky { { 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 0.f }, { -0.f, 0.f }, { 0.f, 0.f }, { 2.f, 2.f }, { 1.f, 0.f }, { 3.f, -0.f } };
+    const fpl::main_index tricky_index( tricky );
+
+    bool all_same = true;
+    for ( const auto &a : tricky ) {
+        for ( const auto &b : tricky ) {
+            all_same = all_same && tricky_index.is_link( a, b ) == fpl::is_main_link( tricky, a, b );
+        }
+
+        all_same = all_same && tricky_index.is_link( a, { 5.f, 5.f } ) == fpl::is_main_link( tricky, a, { 5.f, 5.f } );
+    }
+
+    std::printf( "main_index == is_main_link: %s\n\n", all_same ? "yes" : "NO" );
+
+    // R 4: 16 FPL points per edge, the lookups are all the work the compaction does
+    constexpr int r = 4;
+    std::printf( "%8s %10s %14s %14s %10s\n", "edges", "points", "linear ms", "hashed ms", "speedup" );
+
+    for ( const size_t sides : { size_t( 625 ), size_t( 1250 ), size_t( 2500 ), size_t( 5000 ), size_t( 10000 ) } ) {
+        const auto points = polygon( sides );
+
+        // Points of every segment, uncompacted
+        std::vector<vec2> raw( sides * fpl::capacity( r ) );
+        for ( size_t i = 0; i < sides; ++i ) {
+            const fpl::segment_rf rf { fpl::gen_uniform, 0.2f, 0.3f, { 1u, 0, static_cast< uint32_t >( i ) } };
+            fpl::generate( points[ 2 * i ], points[ 2 * i + 1 ], r, 0, rf, raw.data( ) + i * fpl::capacity( r ) );
+        }
+
+        std::vector<vec2> ref, got;
+        const auto linear_sec = sec_of( [ & ]( ) { ref = compact_linear( points, raw, fpl::capacity( r ) ); } );
+        const auto hashed_sec = sec_of( [ & ]( ) {
+            got = raw;
+
+            const fpl::main_index mains( points );
+            std::vector<size_t> first( sides ), count( sides );
+            for ( size_t i = 0; i < sides; ++i ) {
+                first[ i ] = i * fpl::capacity( r );
+                count[ i ] = fpl::compact_run( mains, fpl::seam_point( points, i ), got.data( ) + first[ i ], fpl::capacity( r ) );
+            }
+
+            fpl::pack_runs( got, first, count, nullptr );
+        } );
+
+        all_same = all_same && got == ref;
+        std::printf( "%8zu %10zu %14.3f %14.3f %9.0fx%s\n", sides, got.size( ), linear_sec * 1e3, hashed_sec * 1e3, linear_sec / hashed_sec,
+                     got == ref ? "" : " (differs)" );
+    }
+
+    return all_same ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// render::lod_cache on an 800 x 600 view: points sent to draw against the canvas width, for the FPL of a triangle
+// up to R 18 and for lines that cross the same two columns back and forth; every pixel the source line passes
+// must have a drawn pixel within a pixel of it
+// Build: g++ -O2 -std=c++20 -pthread bench_lod.cpp ../render/polyline.cpp ../imgui/imgui*.cpp ../fpl/*.cpp -o bench_lod
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/generator.h"
+#include "../render/polyline.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr int width = 800;
+    constexpr int height = 600;
+
+    // Pixels of the view a polyline passes, sampled every 1/8 px
+    struct raster {
+        std::vector<unsigned char> px = std::vector<unsigned char>( width * height, 0 );
+
+        void line( const ImVec2 &a, const ImVec2 &b ) {
+            const auto len = std::hypot( b.x - a.x, b.y - a.y );
+            const auto steps = static_cast< int >( len * 8.f ) + 1;
+
+            for ( int s = 0; s <= steps; ++s ) {
+                const auto t = static_cast< float >( s ) / steps;
+                const auto x = static_cast< int >( std::floor( a.x + ( b.x - a.x ) * t ) );
+                const auto y = static_cast< int >( std::floor( a.y + ( b.y - a.y ) * t ) );
+
+                if ( x >= 0 && x < width && y >= 0 && y < height ) {
+                    px[ y * width + x ] = 1;
+                }
+            }
+        }
+
+        bool near( int x, int y ) const {
+            for ( int dy = -1; dy <= 1; ++dy ) {
+                for ( int dx = -1; dx <= 1; ++dx ) {
+                    const auto nx = x + dx, ny = y + dy;
+                    if ( nx >= 0 && nx < width && ny >= 0 && ny < height && px[ ny * width + nx ] ) {
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+    };
+
+    struct result {
+        bool ok;
+        int points;
+        bool spans;
+    };
+
+    result check( const char *name, const std::vector<vec2> &line ) {
+        render::lod_cache lod;
+
+        const auto start = clock_type::now( );
+        lod.update( line, 1, ImVec2( 0.f, 0.f ), 1.f, ImVec2( 0.f, 0.f ), ImVec2( static_cast< float >( width ), static_cast< float >( height ) ) );
+        const auto ms = std::chrono::duration<double>( clock_type::now( ) - start ).count( ) * 1e3;
+
+        raster src, drawn;
+        for ( size_t n = 1; n < line.size( ); ++n ) {
+            src.line( ImVec2( line[ n - 1 ].x, line[ n - 1 ].y ), ImVec2( line[ n ].x, line[ n ].y ) );
+        }
+
+        const auto &pts = lod.points( );
+        for ( const auto &piece : lod.pieces( ) ) {
+            for ( int n = 1; n < piece.count; ++n ) {
+                drawn.line( pts[ piece.first + n - 1 ], pts[ piece.first + n ] );
+            }
+
+            // A lone point of a piece is still drawn
+            drawn.line( pts[ piece.first ], pts[ piece.first ] );
+        }
+
+        // Every source pixel drawn (within a pixel), and how many drawn ones are further than that from the line
+        size_t missed = 0, extra = 0;
+        for ( int y = 0; y < height; ++y ) {
+            for ( int x = 0; x < width; ++x ) {
+                missed += src.px[ y * width + x ] && !drawn.near( x, y ) ? 1 : 0;
+                extra += drawn.px[ y * width + x ] && !src.near( x, y ) ? 1 : 0;
+            }
+        }
+
+        // 2 * max_spans per column of the view and its margin
+        const auto bound = 2 * render::max_spans * ( width + 3 );
+        const bool ok = missed == 0 && pts.Size <= bound;
+
+        std::printf( "%22s %10zu %8d %6s %8d %8zu %8zu %8.2f\n", name, line.size( ), pts.Size, lod.spans( ) ? "spans" : "runs", bound, missed, extra, ms );
+        return { ok, pts.Size, lod.spans( ) };
+    }
+}
+
+int main( ) {
+    bool ok = true;
+    std::printf( "%22s %10s %8s %6s %8s %8s %8s %8s\n", "line", "points", "drawn", "mode", "bound", "missed", "extra", "ms" );
+
+    // FPL of a triangle, R 4 (runs) .. 18
+    const std::vector<vec2> tri { { 100.f, 500.f }, { 700.f, 500.f }, { 700.f, 500.f }, { 400.f, 80.f }, { 400.f, 80.f }, { 100.f, 500.f } };
+    for ( const int r : { 4, 10, 14, 18 } ) {
+        char name[ 32 ];
+        std::snprintf( name, sizeof( name ), "triangle R %d", r );
+        ok = check( name, fpl::do_fpl( tri, r, 0, fpl::gen_uniform, 0.2f, 0.3f, 1 ) ).ok && ok;
+    }
+
+    // Back and forth over the border of columns 400 and 401 while going down: a run per point before
+    std::vector<vec2> zigzag;
+    for ( int n = 0; n < 200000; ++n ) {
+        zigzag.emplace_back( n % 2 ? 400.8f : 401.2f, 50.f + n * 0.0025f );
+    }
+
+    const auto z = check( "zigzag 2 columns", zigzag );
+    ok = z.ok && z.points <= 4 * render::max_spans && ok;
+
+    // The same over the whole width: a sawtooth going down the view
+    std::vector<vec2> saw;
+    for ( int n = 0; n < 400000; ++n ) {
+        saw.emplace_back( 50.f + ( n % 700 ) + ( n % 2 ? 0.7f : 0.f ), 50.f + n * 0.00125f );
+    }
+
+    ok = check( "sawtooth", saw ).ok && ok;
+
+    // Few points stay a polyline through the same points
+    const std::vector<vec2> few { { 10.f, 10.f }, { 300.f, 200.f }, { 500.f, 100.f } };
+    const auto f = check( "3 points", few );
+    ok = f.ok && !f.spans && f.points == 3 && ok;
+
+    std::printf( "\nbounded by the width, every pixel drawn: %s\n", ok ? "yes" : "NO" );
+    return ok ? 0 : 1;
+}
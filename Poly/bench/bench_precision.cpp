@@ -0,0 +1,147 @@
+// The FPL of a canvas-sized segment made in float, double and 16.16 fixed point against one made in long double,
+// R = 10..24: how far its points are (in their own scalar), how many of them fell onto the point before,
+// the elongation of stream_stat, and points/s
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_precision.cpp ../fpl/*.cpp -o bench_precision
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../types/fixed32.h"
+#include "../types/vec2.h"
+#include "../fpl/engine.h"
+#include "../fpl/generator.h"
+#include "../fpl/stats.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    const char *const names[ ] = { "float", "double", "fixed" };
+
+    template <typename Fn>
+    double sec_of( Fn &&fn ) {
+        const auto start = clock_type::now( );
+        fn( );
+        return std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+    }
+
+    struct point_errors {
+        double max_err = 0.0;
+        double sq_err = 0.0;
+        size_t count = 0;
+        size_t repeats = 0;
+    };
+
+    // Points of ab made in T against the long double ones, as generate_each makes them
+    template <typename T, typename Rf>
+    point_errors errors_in( const vec2 &a, const vec2 &b, int r, Rf &&rf, const std::vector<long double> &ref_x, const std::vector<long double> &ref_y ) {
+        using point = basic_vec2<T>;
+
+        point_errors ret;
+        point last;
+        fpl::generate_each( point( a ), point( b ), r, 0, rf, [ & ]( const point &p ) {
+            const auto dx = static_cast< double >( static_cast< long double >( static_cast< double >( p.x ) ) - ref_x[ ret.count ] );
+            const auto dy = static_cast< double >( static_cast< long double >( static_cast< double >( p.y ) ) - ref_y[ ret.count ] );
+            const auto err = std::hypot( dx, dy );
+
+            ret.max_err = std::fmax( ret.max_err, err );
+            ret.sq_err += err * err;
+            ret.repeats += ret.count > 0 && p == last ? 1 : 0;
+            ++ret.count;
+            last = p;
+        } );
+
+        return ret;
+    }
+}
+
+int main( ) {
+    const vec2 a( 12.f, 700.f );
+    const vec2 b( 1012.f, 650.f );
+    const std::vector<vec2> seg { a, b };
+    const fpl::segment_rf rf { fpl::gen_uniform, 0.2f, 0.3f, { 1, 0, 0 } };
+
+    bool ok = true;
+    std::printf( "%3s %7s %12s %12s %12s %12s %10s\n", "R", "prec", "max err px", "rms err px", "repeats", "elong err", "Mpts/s" );
+
+    for ( int r = 10; r <= 24; r += 2 ) {
+        // Long double points and the elongation of their polyline
+        using ref_point = basic_vec2<long double>;
+        std::vector<long double> ref_x, ref_y;
+        ref_x.reserve( fpl::capacity( r ) );
+        ref_y.reserve( fpl::capacity( r ) );
+        fpl::generate_each( ref_point( a ), ref_point( b ), r, 0, rf, [ & ]( const ref_point &p ) {
+            ref_x.push_back( p.x );
+            ref_y.push_back( p.y );
+        } );
+
+        long double ref_len = 0.0L;
+        for ( size_t n = 1; n < ref_x.size( ); ++n ) {
+            ref_len += std::hypot( ref_x[ n ] - ref_x[ n - 1 ], ref_y[ n ] - ref_y[ n - 1 ] );
+        }
+
+        const auto ref_elong = ref_len / std::hypot( static_cast< long double >( b.x ) - a.x, static_cast< long double >( b.y ) - a.y );
+
+        for ( int prec = fpl::prec_float; prec <= fpl::prec_fixed; ++prec ) {
+            const auto err = prec == fpl::prec_float ? errors_in<float>( a, b, r, rf, ref_x, ref_y )
+                : prec == fpl::prec_double ? errors_in<double>( a, b, r, rf, ref_x, ref_y )
+                : errors_in<fixed32>( a, b, r, rf, ref_x, ref_y );
+
+            // Elongation as the charts get it: made, compacted and summed in prec
+            fpl::stat st;
+            const auto sec = sec_of( [ & ]( ) {
+                st = fpl::stream_stat( seg, r, 0, fpl::gen_uniform, 0.2f, 0.3f, 1, 0, prec );
+            } );
+
+            const auto elong_err = std::fabs( static_cast< long double >( std::get<2>( st ) ) - ref_elong ) / ref_elong;
+            std::printf( "%3d %7s %12.3g %12.3g %12zu %12.3g %10.1f\n", r, names[ prec ], err.max_err, std::sqrt( err.sq_err / err.count ), err.repeats,
+                         static_cast< double >( elong_err ), ref_x.size( ) / sec * 1e-6 );
+
+            ok = ok && err.count == ref_x.size( );
+        }
+    }
+
+    // The stats streamed in every precision are those of its FPL (do_fpl or do_fpl_in), with and without the cutoff
+    const std::vector<vec2> tri { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f }, { 300.f, 500.f }, { 0.f, 0.f } };
+    bool same_stats = true;
+
+    for ( const int delta : { 0, 2 } ) {
+        std::vector<size_t> ends;
+        const auto by_float = fpl::do_stat( tri, fpl::do_fpl( tri, 14, delta, fpl::gen_uniform, 0.2f, 0.3f, 1, 5, &ends ), ends );
+        const auto by_double = fpl::do_stat_in( tri, fpl::do_fpl_in<double>( tri, 14, delta, fpl::gen_uniform, 0.2f, 0.3f, 1, 5, &ends ), ends );
+        const auto by_fixed = fpl::do_stat_in( tri, fpl::do_fpl_in<fixed32>( tri, 14, delta, fpl::gen_uniform, 0.2f, 0.3f, 1, 5, &ends ), ends );
+
+        same_stats = same_stats && by_float == fpl::stream_stat( tri, 14, delta, fpl::gen_uniform, 0.2f, 0.3f, 1, 5, fpl::prec_float )
+            && by_double == fpl::stream_stat( tri, 14, delta, fpl::gen_uniform, 0.2f, 0.3f, 1, 5, fpl::prec_double )
+            && by_fixed == fpl::stream_stat( tri, 14, delta, fpl::gen_uniform, 0.2f, 0.3f, 1, 5, fpl::prec_fixed );
+
+        // do_fpl rounds do_fpl_in for drawing
+        const auto drawn = fpl::do_fpl( tri, 14, delta, fpl::gen_uniform, 0.2f, 0.3f, 1, 5, nullptr, nullptr, fpl::prec_double );
+        const auto kept = fpl::do_fpl_in<double>( tri, 14, delta, fpl::gen_uniform, 0.2f, 0.3f, 1, 5 );
+        same_stats = same_stats && drawn.size( ) == kept.size( ) && drawn.back( ) == vec2( kept.back( ) );
+    }
+
+    // Out of the 16.16 range: saturated, never wrapped, and refused as main points
+    const auto big = fixed32( 100000.0 ), small = fixed32( -1e9 );
+    bool saturates = big == fixed32::highest( ) && small == fixed32::lowest( ) && fixed32( std::nan( "" ) ) == fixed32( )
+        && fixed32( 40000 ) == fixed32::highest( ) && big + big == fixed32::highest( ) && small - big == fixed32::lowest( )
+        && big * big == fixed32::highest( ) && fixed32( 1 ) / fixed32( ) == fixed32::highest( ) && -fixed32::lowest( ) == fixed32::highest( );
+
+    const std::vector<vec2> far { { 0.f, 0.f }, { 100000.f, 0.f } };
+    const std::vector<vec2> edge { { -16000.f, 0.f }, { 16000.f, 0.f } };
+    saturates = saturates && !fpl::in_range( fpl::prec_fixed, far ) && fpl::in_range( fpl::prec_double, far ) && fpl::in_range( fpl::prec_fixed, edge );
+
+    // Up to the edge of the range the fixed FPL is the double one within the 16.16 step
+    std::vector<size_t> edge_ends;
+    const auto edge_fixed = fpl::do_fpl( edge, 8, 0, fpl::gen_uniform, 0.2f, 0.3f, 1, 0, &edge_ends, nullptr, fpl::prec_fixed );
+    const auto edge_double = fpl::do_fpl( edge, 8, 0, fpl::gen_uniform, 0.2f, 0.3f, 1, 0, nullptr, nullptr, fpl::prec_double );
+    saturates = saturates && edge_fixed.size( ) == edge_double.size( ) && edge_fixed.back( ) == edge.back( );
+    for ( size_t n = 0; saturates && n < edge_fixed.size( ); ++n ) {
+        saturates = std::fabs( edge_fixed[ n ].x - edge_double[ n ].x ) < 0.1f && std::fabs( edge_fixed[ n ].y - edge_double[ n ].y ) < 0.1f;
+    }
+
+    ok = ok && same_stats && saturates;
+    std::printf( "\nstream_stat == do_stat( _in ) of do_fpl( _in ): %s, fixed saturates and refuses |x| >= %g: %s\n", same_stats ? "yes" : "NO",
+                 fpl::fixed_range, saturates ? "yes" : "NO" );
+    return ok ? 0 : 1;
+}
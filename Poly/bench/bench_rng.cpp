@@ -0,0 +1,87 @@
+// Offsets/second of the old get_rf (random_device + mt19937 per call) vs fpl::get_rf (Philox, one node key per call)
+// Build: g++ -O2 -std=c++20 -pthread bench_rng.cpp ../fpl/*.cpp -o bench_rng
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "../fpl/generator.h"
+
+namespace legacy {
+    // Old get_rf from Poly.cpp, kept only as the reference for this benchmark
+    float get_rf( int gen_type, float stddev, float s ) {
+        std::random_device rd {};
+        std::mt19937 gen { rd( ) };
+
+        float ret = 0.f;
+
+        // Normal dist
+        if ( gen_type == 0 ) {
+            std::normal_distribution<float> dis( 0.f, stddev );
+            ret = dis( gen );
+        }
+        // Uniform dist
+        else if ( gen_type == 1 ) {
+            std::uniform_real_distribution<float> dis( -s, s );
+            ret = dis( gen );
+        }
+
+        return ret;
+    }
+}
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Min time spent for one measurement
+    constexpr double min_time_sec = 0.5;
+
+    // Offsets drawn between two clock reads
+    constexpr int batch = 1024;
+
+    // Keeps the compiler from dropping the draws
+    volatile float g_sink = 0.f;
+
+    template <typename Fn>
+    double offsets_per_sec( Fn &&fn ) {
+        size_t offsets = 0;
+        double elapsed = 0.0;
+        float sum = 0.f;
+
+        const auto start = clock_type::now( );
+        do {
+            for ( int i = 0; i < batch; ++i ) {
+                sum += fn( );
+            }
+
+            offsets += batch;
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        g_sink = sum;
+        return offsets / elapsed;
+    }
+}
+
+int main( ) {
+    const float stddev = 0.2f;
+    const float s = 0.3f;
+
+    std::printf( "%8s %16s %16s %9s\n", "mode", "legacy off/s", "philox off/s", "speedup" );
+
+    for ( int gen_type = 0; gen_type <= 1; ++gen_type ) {
+        const auto legacy_ops = offsets_per_sec( [ & ]( ) {
+            return legacy::get_rf( gen_type, stddev, s );
+        } );
+
+        // Nodes of a deep level one after another, as a tree draws them
+        const rng::node_key key { 1, 0, 0 };
+        uint64_t k = 0;
+        const auto rng_ops = offsets_per_sec( [ & ]( ) {
+            return fpl::get_rf( gen_type, stddev, s, key, 20, k++ );
+        } );
+
+        std::printf( "%8s %16.0f %16.0f %8.1fx\n", gen_type == 0 ? "normal" : "uniform", legacy_ops, rng_ops, rng_ops / legacy_ops );
+    }
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+// Bulk offsets of rng::fill_uniform / rng::fill_normal: same floats as the per-node path,
+// distribution checks (mean, variance, Kolmogorov-Smirnov) and samples/second vs mt19937 and the per-node path
+// Build: g++ -O2 -std=c++20 [-mavx2] bench_sampler.cpp ../fpl/sampler.cpp -o bench_sampler
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../fpl/philox.h"
+#include "../fpl/sampler.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Min time spent for one measurement
+    constexpr double min_time_sec = 0.2;
+
+    // Samples of the distribution checks
+    constexpr size_t samples = size_t( 1 ) << 22;
+
+    // Kolmogorov-Smirnov: sqrt( n ) * D above this fails at p = 0.001
+    constexpr double ks_limit = 1.95;
+
+    template <typename Fn>
+    double per_sec( Fn &&fn ) {
+        size_t done = 0;
+        double elapsed = 0.0;
+
+        const auto start = clock_type::now( );
+        do {
+            done += fn( );
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        return done / elapsed;
+    }
+
+    // Mean, variance and sqrt( n ) * D against cdf, prints one row, true if all of them are in their bounds
+    template <typename Cdf>
+    bool check( const char *name, std::vector<float> values, double variance, Cdf &&cdf ) {
+        const auto n = static_cast< double >( values.size( ) );
+
+        double sum = 0.0, sum2 = 0.0;
+        for ( const auto v : values ) {
+            sum += v;
+            sum2 += static_cast< double >( v ) * v;
+        }
+
+        const auto mean = sum / n;
+        const auto var = sum2 / n - mean * mean;
+
+        std::sort( values.begin( ), values.end( ) );
+
+        double d = 0.0;
+        for ( size_t i = 0; i < values.size( ); ++i ) {
+            const auto f = cdf( static_cast< double >( values[ i ] ) );
+            d = std::max( d, std::max( f - i / n, ( i + 1 ) / n - f ) );
+        }
+
+        const auto ks = std::sqrt( n ) * d;
+
+        // 5 sigma of the sample mean and of the sample variance
+        const bool ok_mean = std::fabs( mean ) < 5.0 * std::sqrt( variance / n );
+        const bool ok_var = std::fabs( var - variance ) < 5.0 * variance * std::sqrt( 2.0 / n );
+        const bool ok_ks = ks < ks_limit;
+
+        std::printf( "%-10s %12.6f %12.6f %12.6f %10.3f %8s\n", name, mean, var, variance, ks, ok_mean && ok_var && ok_ks ? "ok" : "FAIL" );
+        return ok_mean && ok_var && ok_ks;
+    }
+}
+
+int main( ) {
+    const rng::node_key key { 2024u, 3u, 1u };
+    std::mt19937 pick { 1u };
+    bool ok = true;
+
+    // Bulk = per node, bit for bit, for any head, body and tail
+    bool same = true;
+    for ( int t = 0; t < 2000; ++t ) {
+        const auto l = std::uniform_int_distribution<int>( 0, 29 )( pick );
+        const auto first = std::uniform_int_distribution<uint64_t>( 0, ( uint64_t( 1 ) << l ) - 1 )( pick );
+        const auto count = std::uniform_int_distribution<size_t>( 0, 300 )( pick );
+
+        std::vector<float> bulk_u( count ), bulk_n( count );
+        rng::fill_uniform( key, l, first, count, 0.3f, bulk_u.data( ) );
+        rng::fill_normal( key, l, first, count, 0.2f, bulk_n.data( ) );
+
+        for ( size_t i = 0; i < count; ++i ) {
+            same = same && bulk_u[ i ] == 0.3f * rng::unit_uniform( key, l, first + i );
+            same = same && bulk_n[ i ] == 0.2f * rng::unit_normal( key, l, first + i );
+        }
+    }
+
+    std::printf( "bulk == per node: %s\n", same ? "yes" : "NO" );
+    ok = ok && same;
+
+    // The polynomials against libm over every input Box-Muller can give them
+    double log_err = 0.0, sincos_err = 0.0;
+    for ( uint32_t q = 0; q < ( 1u << 24 ); ++q ) {
+        const auto u1 = static_cast< float >( q + 1 ) * ( 1.f / 16777216.f );
+        const auto ref = std::log( static_cast< double >( u1 ) );
+        if ( ref != 0.0 ) {
+            log_err = std::max( log_err, std::fabs( ( rng::log_unit( u1 ) - ref ) / ref ) );
+        }
+
+        float sn = 0.f, cs = 0.f;
+        rng::sincos_turn( q, sn, cs );
+        const auto theta = 6.283185307179586 * q / 16777216.0;
+        sincos_err = std::max( sincos_err, std::max( std::fabs( sn - std::sin( theta ) ), std::fabs( cs - std::cos( theta ) ) ) );
+    }
+
+    std::printf( "log max rel err: %.3g, sin/cos max abs err: %.3g\n", log_err, sincos_err );
+    ok = ok && log_err < 1e-6 && sincos_err < 1e-6;
+
+    // Distributions
+    std::vector<float> values( samples );
+    std::printf( "\n%-10s %12s %12s %12s %10s %8s\n", "dist", "mean", "variance", "expected", "ks", "" );
+
+    rng::fill_uniform( key, 22, 0, samples, 1.f, values.data( ) );
+    ok = check( "uniform", values, 1.0 / 3.0, [ ]( double x ) { return std::clamp( ( x + 1.0 ) / 2.0, 0.0, 1.0 ); } ) && ok;
+
+    rng::fill_normal( key, 22, 0, samples, 1.f, values.data( ) );
+    ok = check( "normal", values, 1.0, [ ]( double x ) { return 0.5 * std::erfc( -x / std::sqrt( 2.0 ) ); } ) && ok;
+
+    // Offsets of the many short trees of a sweep: level 0 of every stream
+    for ( size_t i = 0; i < samples; ++i ) {
+        values[ i ] = rng::unit_normal( { 2024u, i, 0u }, 0, 0 );
+    }
+    ok = check( "normal/st", values, 1.0, [ ]( double x ) { return 0.5 * std::erfc( -x / std::sqrt( 2.0 ) ); } ) && ok;
+
+    // Samples/second, the sum keeps the compiler from dropping the work
+    constexpr size_t batch = size_t( 1 ) << 16;
+    std::vector<float> buf( batch );
+    volatile float sink = 0.f;
+    uint64_t first = 0;
+
+    std::printf( "\n%-10s %16s %16s %16s %9s\n", "dist", "mt19937 /s", "per node /s", "bulk /s", "bulk/node" );
+
+    for ( int normal = 0; normal <= 1; ++normal ) {
+        std::mt19937 gen { 42u };
+        std::normal_distribution<float> dis_n { 0.f, 1.f };
+        std::uniform_real_distribution<float> dis_u { -1.f, 1.f };
+
+        const auto mt_ops = per_sec( [ & ]( ) {
+            float sum = 0.f;
+            for ( size_t i = 0; i < batch; ++i ) {
+                sum += normal ? dis_n( gen ) : dis_u( gen );
+            }
+            sink = sink + sum;
+            return batch;
+        } );
+
+        const auto node_ops = per_sec( [ & ]( ) {
+            float sum = 0.f;
+            for ( size_t i = 0; i < batch; ++i ) {
+                sum += normal ? rng::unit_normal( key, 29, first + i ) : rng::unit_uniform( key, 29, first + i );
+            }
+            first += batch;
+            sink = sink + sum;
+            return batch;
+        } );
+
+        const auto bulk_ops = per_sec( [ & ]( ) {
+            if ( normal ) {
+                rng::fill_normal( key, 29, first, batch, 1.f, buf.data( ) );
+            }
+            else {
+                rng::fill_uniform( key, 29, first, batch, 1.f, buf.data( ) );
+            }
+            first += batch;
+            sink = sink + buf[ batch / 2 ];
+            return batch;
+        } );
+
+        std::printf( "%-10s %16.0f %16.0f %16.0f %8.1fx\n", normal ? "normal" : "uniform", mt_ops, node_ops, bulk_ops, bulk_ops / node_ops );
+    }
+
+    return ok ? 0 : 1;
+}
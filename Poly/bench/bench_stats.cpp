@@ -0,0 +1,124 @@
+// Points/second of the old three-pass stats (get_max + get_mean + get_elong) vs the fused fpl::line_pass
+// for R = 10..22, and how far both are from a double precision reference
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_stats.cpp ../fpl/*.cpp -o bench_stats
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/engine.h"
+#include "../fpl/stats.h"
+
+namespace legacy {
+    // Old stats from stats.cpp, kept only as the reference for this benchmark
+    float get_max( const std::vector<vec2> &points, const float &_y ) {
+        auto ret = *std::max_element( points.begin( ), points.end( ), [ & ]( const vec2 &a, const vec2 &b ) {
+            auto a_y = std::fabs( a.y - _y );
+            auto b_y = std::fabs( b.y - _y );
+            return a_y < b_y;
+        } );
+
+        return std::fabs( ret.y - _y );
+    }
+
+    float get_mean( const std::vector<vec2> &points, const float &_y ) {
+        float sum = 0.f;
+        for ( const auto &p : points ) {
+            sum += std::fabs( p.y - _y );
+        }
+
+        return sum / points.size( );
+    }
+
+    float get_elong( const std::vector<vec2> &points ) {
+        float sum = 0.f;
+        for ( size_t i = 0; i < points.size( ) - 1; ++i ) {
+            auto vec = points[ i ] - points[ i + 1 ];
+            sum += vec.length( );
+        }
+
+        return sum / ( points[ 0 ] - points.back( ) ).length( );
+    }
+}
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Min time spent for one measurement
+    constexpr double min_time_sec = 0.2;
+
+    template <typename Fn>
+    double points_per_sec( size_t points, Fn &&fn ) {
+        size_t runs = 0;
+        double elapsed = 0.0;
+
+        const auto start = clock_type::now( );
+        do {
+            fn( );
+            ++runs;
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        return points * runs / elapsed;
+    }
+
+    double rel_err( double value, double ref ) {
+        return ref != 0.0 ? std::fabs( value - ref ) / std::fabs( ref ) : std::fabs( value );
+    }
+}
+
+int main( ) {
+    const vec2 a( 0.f, 300.f );
+    const vec2 b( 1000.f, 300.f );
+
+    std::printf( "%3s %10s %14s %14s %8s %12s %12s\n", "R", "points", "3-pass pts/s", "fused pts/s", "speedup", "3-pass err", "fused err" );
+
+    volatile float sink = 0.f;
+
+    for ( int r = 10; r <= 22; r += 2 ) {
+        std::mt19937 gen { 42u };
+        std::uniform_real_distribution<float> dis { -0.3f, 0.3f };
+
+        std::vector<vec2> points( fpl::capacity( r ) );
+        points.resize( fpl::generate( a, b, r, 0, [ & ]( ) { return dis( gen ); }, points.data( ) ) );
+
+        const auto y = ( a.y + b.y ) / 2;
+        const auto old_pps = points_per_sec( points.size( ), [ & ]( ) {
+            sink = sink + legacy::get_max( points, y ) + legacy::get_mean( points, y ) + legacy::get_elong( points );
+        } );
+
+        const auto fused_pps = points_per_sec( points.size( ), [ & ]( ) {
+            const auto sums = fpl::line_pass( points.data( ), points.size( ), a, b );
+            sink = sink + sums.max_dev + sums.sum_dev / sums.count + sums.length / ( b - a ).length( );
+        } );
+
+        // Reference in double
+        double ref_max = 0.0, ref_sum = 0.0, ref_len = 0.0;
+        for ( size_t k = 0; k < points.size( ); ++k ) {
+            const auto dev = std::fabs( static_cast< double >( points[ k ].y ) - y );
+            ref_max = std::max( ref_max, dev );
+            ref_sum += dev;
+
+            if ( k + 1 < points.size( ) ) {
+                ref_len += std::hypot( static_cast< double >( points[ k + 1 ].x ) - points[ k ].x, static_cast< double >( points[ k + 1 ].y ) - points[ k ].y );
+            }
+        }
+
+        const auto ref_mean = ref_sum / points.size( );
+        const auto ref_elong = ref_len / 1000.0;
+
+        const auto old_err = std::max( { rel_err( legacy::get_max( points, y ), ref_max ), rel_err( legacy::get_mean( points, y ), ref_mean ),
+                                         rel_err( legacy::get_elong( points ), ref_elong ) } );
+
+        const auto sums = fpl::line_pass( points.data( ), points.size( ), a, b );
+        const auto fused_err = std::max( { rel_err( sums.max_dev, ref_max ), rel_err( sums.sum_dev / sums.count, ref_mean ),
+                                           rel_err( sums.length / 1000.f, ref_elong ) } );
+
+        std::printf( "%3d %10zu %14.0f %14.0f %7.2fx %12.3g %12.3g\n", r, points.size( ), old_pps, fused_pps, fused_pps / old_pps, old_err, fused_err );
+    }
+
+    return 0;
+}
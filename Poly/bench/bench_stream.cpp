@@ -0,0 +1,96 @@
+// Stats of one realisation made two ways: do_fpl + do_stat (the whole FPL in memory) vs fpl::stream_stat
+// (the points go straight into the sums), for R = 1..26: time, peak FPL memory and a check that both give the same stats
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_stream.cpp ../fpl/*.cpp -o bench_stream
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/engine.h"
+#include "../fpl/generator.h"
+#include "../fpl/stats.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Min time spent for one measurement
+    constexpr double min_time_sec = 0.2;
+
+    template <typename Fn>
+    double sec_per_run( Fn &&fn ) {
+        size_t runs = 0;
+        double elapsed = 0.0;
+
+        const auto start = clock_type::now( );
+        do {
+            fn( );
+            ++runs;
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        return elapsed / runs;
+    }
+
+    struct shape {
+        const char *name;
+        std::vector<vec2> points;
+        int delta;
+    };
+}
+
+int main( ) {
+    // Main lines as pairs (a, b)
+    const std::vector<shape> shapes {
+        { "segment", { { 0.f, 300.f }, { 1000.f, 300.f } }, 0 },
+        { "triangle", { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f }, { 300.f, 500.f }, { 0.f, 0.f } }, 0 },
+        { "apart", { { 0.f, 0.f }, { 400.f, 100.f }, { 500.f, 0.f }, { 900.f, -50.f } }, 0 },
+        { "cutoff", { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f } }, 2 },
+    };
+
+    // The check covers both generators and every path of stream_stat (cutoff, small tree, tiles)
+    bool all_same = true;
+    for ( const auto &sh : shapes ) {
+        for ( int gen_type = fpl::gen_normal; gen_type <= fpl::gen_uniform; ++gen_type ) {
+            for ( int r = 0; r <= 16; ++r ) {
+                for ( uint64_t stream = 1; stream <= 3; ++stream ) {
+                    std::vector<size_t> ends;
+                    const auto fpl_points = fpl::do_fpl( sh.points, r, sh.delta, gen_type, 0.2f, 0.3f, 7u, stream, &ends );
+                    const auto ref = fpl::do_stat( sh.points, fpl_points, ends );
+                    const auto got = fpl::stream_stat( sh.points, r, sh.delta, gen_type, 0.2f, 0.3f, 7u, stream );
+
+                    if ( got != ref ) {
+                        std::printf( "differs: %s, gen %d, R %d, stream %llu\n", sh.name, gen_type, r, static_cast< unsigned long long >( stream ) );
+                        all_same = false;
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf( "stream_stat == do_stat( do_fpl ): %s\n\n", all_same ? "yes" : "NO" );
+
+    std::printf( "%3s %10s %14s %14s %8s %14s\n", "R", "points", "do_fpl ms", "stream ms", "speedup", "FPL memory" );
+
+    const auto &seg = shapes[ 0 ].points;
+    for ( int r = 10; r <= 26; r += 2 ) {
+        fpl::stat ref, got;
+        const auto full_sec = sec_per_run( [ & ]( ) {
+            std::vector<size_t> ends;
+            const auto fpl_points = fpl::do_fpl( seg, r, 0, fpl::gen_uniform, 0.2f, 0.3f, 7u, 1u, &ends );
+            ref = fpl::do_stat( seg, fpl_points, ends );
+        } );
+
+        const auto stream_sec = sec_per_run( [ & ]( ) {
+            got = fpl::stream_stat( seg, r, 0, fpl::gen_uniform, 0.2f, 0.3f, 7u, 1u );
+        } );
+
+        all_same = all_same && got == ref;
+
+        // The streaming path only keeps its fixed tile
+        const auto bytes = fpl::capacity( r ) * sizeof( vec2 );
+        std::printf( "%3d %10zu %14.3f %14.3f %7.2fx %12.1f MB%s\n", r, fpl::capacity( r ), full_sec * 1e3, stream_sec * 1e3, full_sec / stream_sec,
+                     bytes / 1048576.0, got == ref ? "" : " (differs)" );
+    }
+
+    return all_same ? 0 : 1;
+}
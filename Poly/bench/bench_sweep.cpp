@@ -0,0 +1,100 @@
+// Scaling of fpl::sweep over the thread count, and a check that the stats don't depend on it
+// Build: g++ -O2 -std=c++20 -pthread bench_sweep.cpp ../fpl/*.cpp -o bench_sweep
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/engine.h"
+#include "../fpl/generator.h"
+#include "../fpl/pool.h"
+#include "../fpl/stats.h"
+#include "../fpl/sweep.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Same shape as the uniform sweep of get_stats: J values of s, N realisations each
+    constexpr int r = 12;
+    constexpr int delta = 0;
+    constexpr size_t values = 30;
+    constexpr size_t n = 50;
+    constexpr float sj = 0.01f;
+    constexpr uint64_t seed = 1;
+
+    // One realisation: FPL of the segment ab + its stats (as do_stat does it)
+    fpl::stat realise( size_t v, size_t i, std::vector<vec2> &out ) {
+        const vec2 a( 0.f, 300.f );
+        const vec2 b( 1000.f, 300.f );
+
+        // A tree of its own per realisation
+        const fpl::segment_rf rf { fpl::gen_uniform, 0.f, sj * ( v + 1 ), { seed, 1 + v * n + i, 0 } };
+
+        out.resize( fpl::capacity( r ) );
+        const auto count = fpl::generate( a, b, r, delta, rf, out.data( ) );
+
+        const auto sums = fpl::line_pass( out.data( ), count, a, b );
+        return { sums.max_dev, sums.sum_dev / sums.count, sums.length / ( b - a ).length( ) };
+    }
+
+    std::vector<fpl::stat> run( fpl::pool &workers, double &sec ) {
+        const auto start = clock_type::now( );
+
+        auto stats = fpl::sweep( workers, values, n, [ ]( size_t v, size_t i ) {
+            thread_local std::vector<vec2> t_out;
+            return realise( v, i, t_out );
+        } );
+
+        sec = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        return stats;
+    }
+}
+
+// Usage: bench_sweep [max threads], hardware threads by default
+int main( int argc, char **argv ) {
+    unsigned max_threads = argc > 1 ? static_cast< unsigned >( std::atoi( argv[ 1 ] ) ) : std::thread::hardware_concurrency( );
+    if ( max_threads == 0 ) {
+        max_threads = 1;
+    }
+
+    // 1, 2, 4... and the max itself
+    std::vector<unsigned> counts;
+    for ( unsigned t = 1; t < max_threads; t *= 2 ) {
+        counts.push_back( t );
+    }
+    counts.push_back( max_threads );
+
+    std::printf( "%8s %12s %10s %11s %10s\n", "threads", "time, ms", "speedup", "efficiency", "identical" );
+
+    std::vector<fpl::stat> reference;
+    double base_sec = 0.0;
+    bool all_same = true;
+
+    for ( const auto threads : counts ) {
+        fpl::pool workers( threads );
+
+        // Warm up + best of 3
+        double sec = 0.0, best = 1e30;
+        std::vector<fpl::stat> stats;
+        for ( int k = 0; k < 4; ++k ) {
+            stats = run( workers, sec );
+            best = k > 0 && sec < best ? sec : best;
+        }
+
+        if ( reference.empty( ) ) {
+            reference = stats;
+            base_sec = best;
+        }
+
+        // Bit-identical, not just close
+        const bool same = stats == reference;
+        all_same = all_same && same;
+        const auto speedup = base_sec / best;
+
+        std::printf( "%8u %12.2f %9.2fx %10.0f%% %10s\n", workers.size( ), best * 1e3, speedup, 100.0 * speedup / workers.size( ), same ? "yes" : "NO" );
+    }
+
+    return all_same ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+// fpl::fpl_tree: the FPL at R made from the kept levels vs do_fpl from scratch, R going up one at a time
+// (as the R slider does it) and back to R - 1, end to end (levels and polyline), then a polygon with one vertex dragged, added or deleted
+// (at the end and in the middle of the chain),
+// and checks that both give the same points at every R, up and down, and after every edit
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_tree.cpp ../fpl/*.cpp -o bench_tree
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/generator.h"
+#include "../fpl/tree.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    template <typename Fn>
+    double sec_of( Fn &&fn ) {
+        const auto start = clock_type::now( );
+        fn( );
+        return std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+    }
+
+    struct shape {
+        const char *name;
+        std::vector<vec2> points;
+        int delta;
+    };
+}
+
+int main( ) {
+    // Main lines as pairs (a, b)
+    const std::vector<shape> shapes {
+        { "segment", { { 0.f, 300.f }, { 1000.f, 300.f } }, 0 },
+        { "triangle", { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f }, { 300.f, 500.f }, { 0.f, 0.f } }, 0 },
+        { "apart", { { 0.f, 0.f }, { 400.f, 100.f }, { 500.f, 0.f }, { 900.f, -50.f } }, 0 },
+        { "cutoff", { { 0.f, 0.f }, { 600.f, 0.f }, { 600.f, 0.f }, { 300.f, 500.f } }, 2 },
+    };
+
+    // R up to 14 and back down, both generators, the cutoff and the whole levels paths
+    bool all_same = true;
+    for ( const auto &sh : shapes ) {
+        for ( int gen_type = fpl::gen_normal; gen_type <= fpl::gen_uniform; ++gen_type ) {
+            fpl::settings cfg;
+            cfg.delta = sh.delta;
+            cfg.gen_type = gen_type;
+            cfg.seed = 7;
+
+            fpl::fpl_tree tree;
+            tree.reset( sh.points, cfg );
+
+            std::vector<int> depths;
+            for ( int r = 0; r <= 14; ++r ) {
+                depths.push_back( r );
+            }
+            for ( int r = 13; r >= 0; r -= 3 ) {
+                depths.push_back( r );
+            }
+
+            for ( const auto r : depths ) {
+                cfg.r = r;
+                tree.set_depth( r );
+
+                std::vector<size_t> ends, tree_ends;
+                const auto ref = fpl::do_fpl( sh.points, cfg.r, cfg.delta, cfg.gen_type, cfg.stddev, cfg.s( ), cfg.seed, 0, &ends );
+                const auto got = tree.polyline( &tree_ends );
+
+                if ( got != ref || tree_ends != ends ) {
+                    std::printf( "differs: %s, gen %d, R %d\n", sh.name, gen_type, r );
+                    all_same = false;
+                }
+            }
+
+            // Same settings but R: the levels stay
+            all_same = tree.reset( sh.points, cfg ) == sh.points.size( ) / 2 && tree.levels( ) == 14 && all_same;
+        }
+    }
+
+    std::printf( "fpl_tree == do_fpl: %s\n\n", all_same ? "yes" : "NO" );
+
+    // The R slider going up by one
+    const auto &tri = shapes[ 1 ].points;
+    fpl::settings cfg;
+    cfg.delta = 0;
+
+    fpl::fpl_tree tree;
+    tree.reset( tri, cfg );
+
+    // The polyline is compacted as do_fpl does it, the new level is all the tree makes;
+    // end to end is the level and the polyline, R - 1 again is a kept level and its kept runs
+    std::printf( "%3s %10s %12s %12s %12s %12s %8s %12s %8s\n", "R", "points", "do_fpl ms", "level ms", "polyline ms", "end ms", "speedup", "R-1 end ms",
+                 "speedup" );
+    for ( int r = 1; r <= 22; ++r ) {
+        cfg.r = r;
+
+        std::vector<vec2> ref;
+        const auto full_sec = sec_of( [ & ]( ) { ref = fpl::do_fpl( tri, cfg ); } );
+        const auto level_sec = sec_of( [ & ]( ) { tree.set_depth( r ); } );
+        const auto poly_sec = sec_of( [ & ]( ) { tree.polyline( ); } );
+        const auto tree_sec = level_sec + poly_sec;
+        const bool same = tree.polyline( ) == ref;
+
+        // And back down: a kept level, its runs compacted when it was the deepest one
+        const auto back_sec = sec_of( [ & ]( ) {
+            tree.set_depth( r - 1 );
+            tree.polyline( );
+        } );
+
+        cfg.r = r - 1;
+        const auto back_full_sec = sec_of( [ & ]( ) { ref = fpl::do_fpl( tri, cfg ); } );
+        const bool back_same = tree.polyline( ) == ref;
+        tree.set_depth( r );
+
+        all_same = all_same && same && back_same;
+        if ( r >= 10 ) {
+            std::printf( "%3d %10zu %12.3f %12.3f %12.3f %12.3f %7.2fx %12.3f %7.0fx%s\n", r, tree.polyline( ).size( ), full_sec * 1e3, level_sec * 1e3, poly_sec * 1e3,
+                         tree_sec * 1e3, full_sec / tree_sec, back_sec * 1e3, back_full_sec / back_sec, same && back_same ? "" : " (differs)" );
+        }
+    }
+
+    // Polygon of 256 segments, its vertex v dragged around (the two segments on it change)
+    constexpr size_t sides = 256;
+    std::vector<vec2> polygon;
+    for ( size_t v = 0; v < sides; ++v ) {
+        const auto angle = 2.f * M_PI * v / sides;
+        const auto next = 2.f * M_PI * ( v + 1 ) / sides;
+        polygon.emplace_back( 400.f + 300.f * std::cos( angle ), 400.f + 300.f * std::sin( angle ) );
+        polygon.emplace_back( 400.f + 300.f * std::cos( next ), 400.f + 300.f * std::sin( next ) );
+    }
+
+    cfg.r = 10;
+    cfg.delta = 2;
+    tree.reset( polygon, cfg );
+    tree.set_depth( cfg.r );
+
+    double full_sec = 0.0, edit_sec = 0.0;
+    bool edits_same = true;
+    for ( int step = 0; step < 20; ++step ) {
+        const auto v = static_cast< size_t >( step * 37 ) % sides;
+
+        // Vertex v is point b of segment v - 1 and point a of segment v
+        const vec2 moved( 400.f + step * 3.f, 420.f - step * 2.f );
+        polygon[ 2 * v ] = moved;
+        polygon[ ( 2 * v + 2 * sides - 1 ) % ( 2 * sides ) ] = moved;
+
+        // The last segment goes and comes back (a point deleted, then added)
+        auto edited = polygon;
+        if ( step % 5 == 4 ) {
+            edited.resize( edited.size( ) - 2 );
+        }
+
+        std::vector<vec2> ref, got;
+        full_sec += sec_of( [ & ]( ) { ref = fpl::do_fpl( edited, cfg ); } );
+        edit_sec += sec_of( [ & ]( ) {
+            tree.reset( edited, cfg );
+            tree.set_depth( cfg.r );
+            got = tree.polyline( );
+        } );
+
+        edits_same = edits_same && got == ref;
+    }
+
+    all_same = all_same && edits_same;
+
+    std::printf( "\npolygon of %zu segments, R %d, a vertex moved: do_fpl %.3f ms, tree %.3f ms (%.2fx), same: %s\n", sides, cfg.r, full_sec / 20 * 1e3,
+                 edit_sec / 20 * 1e3, full_sec / edit_sec, edits_same ? "yes" : "NO" );
+
+    // A segment deleted in the middle of the chain, then a vertex added in the middle of another one (it splits in two):
+    // the segments after them keep their levels wherever they are now, and their points in the polyline
+    tree.reset( polygon, cfg );
+    tree.set_depth( cfg.r );
+
+    bool mid_same = true;
+    for ( int step = 0; step < 2; ++step ) {
+        std::vector<size_t> old_ends, ends, tree_ends;
+        const auto old_fpl = tree.polyline( &old_ends );
+        const auto old_segments = polygon.size( ) / 2;
+
+        // The run of the segment after the edit may lose or gain its point a (at the seam), the tail after it is the same
+        size_t old_tail = 0, tail = 0;
+        if ( step == 0 ) {
+            polygon.erase( polygon.begin( ) + 2 * 128, polygon.begin( ) + 2 * 128 + 2 );
+            old_tail = old_ends[ 129 ] + 1;
+        }
+        else {
+            const auto a = polygon[ 2 * 64 ];
+            const auto b = polygon[ 2 * 64 + 1 ];
+            const auto mid = ( a + b ) / 2 + ( b - a ).perp( ) * 0.1f;
+            polygon[ 2 * 64 + 1 ] = mid;
+            polygon.insert( polygon.begin( ) + 2 * 65, { mid, b } );
+            old_tail = old_ends[ 65 ] + 1;
+        }
+
+        std::vector<vec2> ref, got;
+        size_t kept = 0;
+        const auto full = sec_of( [ & ]( ) { ref = fpl::do_fpl( polygon, cfg.r, cfg.delta, cfg.gen_type, cfg.stddev, cfg.s( ), cfg.seed, 0, &ends ); } );
+        const auto edit = sec_of( [ & ]( ) {
+            kept = tree.reset( polygon, cfg );
+            tree.set_depth( cfg.r );
+            got = tree.polyline( &tree_ends );
+        } );
+
+        tail = ends[ step == 0 ? 128 : 66 ] + 1;
+        const bool tail_same = old_fpl.size( ) - old_tail == got.size( ) - tail && std::equal( old_fpl.begin( ) + old_tail, old_fpl.end( ), got.begin( ) + tail );
+        const bool same = got == ref && tree_ends == ends && kept == old_segments - 1 && tail_same;
+        mid_same = mid_same && same;
+
+        std::printf( "%s: %zu of %zu segments kept, tail kept: %s, do_fpl %.3f ms, tree %.3f ms (%.2fx), same: %s\n", step == 0 ? "segment 128 deleted" : "vertex added to segment 64",
+                     kept, old_segments, tail_same ? "yes" : "NO", full * 1e3, edit * 1e3, full / edit, same ? "yes" : "NO" );
+    }
+
+    all_same = all_same && mid_same;
+
+    // Straight FPL (stddev 0): segment 0 goes through x = 0, 1, .. 8 at R 3; segment 5 moved onto ( 2, 0 ), ( 3, 0 ) makes
+    // a main link there and segment 0 compacts to other points, point b of segment 3 moved onto point a of segment 4
+    // makes a seam; the kept polyline is spliced, it must stay what do_fpl gives
+    std::vector<vec2> apart { { 0.f, 0.f }, { 8.f, 0.f } };
+    for ( int i = 1; i < 20; ++i ) {
+        apart.emplace_back( 20.f * i, 20.f );
+        apart.emplace_back( 20.f * i + 10.f, 30.f );
+    }
+
+    cfg.r = 3;
+    cfg.delta = 0;
+    cfg.gen_type = fpl::gen_normal;
+    cfg.stddev = 0.f;
+
+    bool splice_same = true;
+    for ( int step = 0; step < 5; ++step ) {
+        auto edited = apart;
+        if ( step == 1 || step == 3 ) {
+            edited[ 10 ] = vec2( 2.f, 0.f );
+            edited[ 11 ] = vec2( 3.f, 0.f );
+        }
+        if ( step == 2 || step == 3 ) {
+            edited[ 7 ] = edited[ 8 ];
+        }
+
+        tree.reset( edited, cfg );
+        tree.set_depth( cfg.r );
+
+        std::vector<size_t> ends, tree_ends;
+        const auto ref = fpl::do_fpl( edited, cfg.r, cfg.delta, cfg.gen_type, cfg.stddev, cfg.s( ), cfg.seed, 0, &ends );
+        splice_same = splice_same && tree.polyline( &tree_ends ) == ref && tree_ends == ends;
+    }
+
+    all_same = all_same && splice_same;
+    std::printf( "main links and seams moved, spliced polyline == do_fpl: %s\n", splice_same ? "yes" : "NO" );
+
+    return all_same ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// fpl::generate_unrolled (an instance per R) against generate_bfs and the depth-first generate, R = 1 .. unrolled_depth:
+// the same points, and points/s with the offsets of segment_rf as do_fpl and stream_stat draw them
+// Build: g++ -O2 -std=c++20 [-mavx2] -pthread bench_unrolled.cpp ../fpl/*.cpp -o bench_unrolled
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/bfs.h"
+#include "../fpl/engine.h"
+#include "../fpl/generator.h"
+#include "../fpl/unrolled.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Min time spent for one measurement, rounds of every path in turn (the best one counts)
+    constexpr double min_time_sec = 0.05;
+    constexpr int rounds = 7;
+
+    template <typename Fn>
+    double calls_per_sec( Fn &&fn ) {
+        size_t runs = 0;
+        double elapsed = 0.0;
+
+        const auto start = clock_type::now( );
+        do {
+            fn( runs );
+            ++runs;
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        return runs / elapsed;
+    }
+}
+
+int main( ) {
+    const vec2 a( 0.f, 300.f );
+    const vec2 b( 1000.f, 300.f );
+
+    // The same points as both other paths, with every kind of rf
+    bool ok = true;
+    fpl::bfs_buffers bfs;
+
+    for ( int r = 0; r <= fpl::unrolled_depth; ++r ) {
+        const fpl::segment_rf rf { fpl::gen_normal, 0.2f, 0.3f, { 3, 1, 2 } };
+        const auto count = fpl::capacity( r );
+
+        std::vector<vec2> ref( count ), by_node( count ), by_level( count ), by_seq( count ), seq_ref( count );
+        fpl::generate( a, b, r, 0, rf, ref.data( ) );
+        fpl::generate_unrolled( a, b, r, [ & ]( int l, uint64_t k ) { return rf( l, k ); }, by_node.data( ) );
+        fpl::generate_unrolled( a, b, r, rf, by_level.data( ) );
+
+        // rf( ) in depth-first order
+        std::mt19937 gen_a { 7u }, gen_b { 7u };
+        std::uniform_real_distribution<float> dis { -0.3f, 0.3f };
+        fpl::generate( a, b, r, 0, [ & ]( ) { return dis( gen_a ); }, seq_ref.data( ) );
+        fpl::generate_unrolled( a, b, r, [ & ]( ) { return dis( gen_b ); }, by_seq.data( ) );
+
+        std::vector<vec2> bfs_points( count );
+        fpl::generate_bfs( a, b, r, rf, bfs_points.data( ), bfs );
+
+        if ( by_node != ref || by_level != ref || bfs_points != ref || by_seq != seq_ref ) {
+            std::printf( "differs: R %d\n", r );
+            ok = false;
+        }
+    }
+
+    std::printf( "generate_unrolled == generate == generate_bfs: %s\n\n", ok ? "yes" : "NO" );
+    std::printf( "%3s %8s %14s %14s %14s %10s %10s\n", "R", "points", "generate /s", "bfs /s", "unrolled /s", "vs bfs", "vs dfs" );
+    std::printf( "(do_fpl and stream_stat take the unrolled instance up to R %d)\n", fpl::unrolled_cutoff );
+
+    volatile float sink = 0.f;
+    for ( int r = 1; r <= fpl::unrolled_depth; ++r ) {
+        std::vector<vec2> out( fpl::capacity( r ) );
+
+        // A new tree per call, as the realisations of a sweep get
+        auto rf_of = [ ]( size_t run ) {
+            return fpl::segment_rf { fpl::gen_uniform, 0.2f, 0.3f, { 1, static_cast< uint64_t >( run ), 0 } };
+        };
+
+        double dfs = 0.0, level = 0.0, unrolled = 0.0;
+        for ( int round = 0; round < rounds; ++round ) {
+            dfs = std::max( dfs, calls_per_sec( [ & ]( size_t run ) {
+                fpl::generate( a, b, r, 0, rf_of( run ), out.data( ) );
+                sink = sink + out[ 1 ].y;
+            } ) );
+
+            level = std::max( level, calls_per_sec( [ & ]( size_t run ) {
+                fpl::generate_bfs( a, b, r, rf_of( run ), out.data( ), bfs );
+                sink = sink + out[ 1 ].y;
+            } ) );
+
+            unrolled = std::max( unrolled, calls_per_sec( [ & ]( size_t run ) {
+                fpl::generate_unrolled( a, b, r, rf_of( run ), out.data( ) );
+                sink = sink + out[ 1 ].y;
+            } ) );
+        }
+
+        std::printf( "%3d %8zu %14.0f %14.0f %14.0f %9.2fx %9.2fx\n", r, out.size( ), dfs, level, unrolled, unrolled / level, unrolled / dfs );
+    }
+
+    return ok ? 0 : 1;
+}
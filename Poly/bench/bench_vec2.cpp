@@ -0,0 +1,146 @@
+// vec2x4 / vec2x8 against vec2 point by point (add, sub, scale, perp, dot, length the same floats,
+// the rsqrt normalise within a few ulps), and points/s of the link lengths and the normalise, one point vs a batch at a time
+// Build: g++ -O2 -std=c++20 [-mavx2] bench_vec2.cpp -o bench_vec2
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../types/vec2x.h"
+
+// vec2 in constant expressions
+static_assert( vec2( 3.f, 4.f ).perp( ) == vec2( -4.f, 3.f ) );
+static_assert( vec2( 3.f, 4.f ).dot_product( vec2( 3.f, 4.f ) ) == 25.f );
+static_assert( ( vec2( 1.f, 2.f ) + vec2( 3.f, 4.f ) ) * 0.5f == vec2( 2.f, 3.f ) );
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    // Min time spent for one measurement
+    constexpr double min_time_sec = 0.2;
+
+    template <typename Fn>
+    double points_per_sec( size_t points, Fn &&fn ) {
+        size_t runs = 0;
+        double elapsed = 0.0;
+
+        const auto start = clock_type::now( );
+        do {
+            fn( );
+            ++runs;
+            elapsed = std::chrono::duration<double>( clock_type::now( ) - start ).count( );
+        } while ( elapsed < min_time_sec );
+
+        return points * runs / elapsed;
+    }
+
+    bool same( float a, float b ) {
+        return a == b || ( std::isnan( a ) && std::isnan( b ) );
+    }
+
+    // Every op of a batch of N against vec2 on the same points, max relative error of normalized( ) to err
+    template <size_t N>
+    bool check( const std::vector<vec2> &p, const std::vector<float> &s, double &err ) {
+        bool ok = true;
+
+        for ( size_t i = 0; i + 2 * N <= p.size( ); i += N ) {
+            const auto a = vec2xn<N>::load( p.data( ) + i );
+            const auto b = vec2xn<N>::load( p.data( ) + i + N );
+            const auto f = f32xn<N>::load( s.data( ) + i );
+
+            vec2 sum[ N ], diff[ N ], scaled[ N ], perp[ N ], unit[ N ];
+            float dot[ N ], len[ N ];
+
+            ( a + b ).store( sum );
+            ( a - b ).store( diff );
+            ( a * f ).store( scaled );
+            a.perp( ).store( perp );
+            a.normalized( ).store( unit );
+            a.dot( b ).store( dot );
+            a.length( ).store( len );
+
+            for ( size_t j = 0; j < N; ++j ) {
+                const auto &pa = p[ i + j ];
+                const auto &pb = p[ i + N + j ];
+
+                ok = ok && sum[ j ] == pa + pb && diff[ j ] == pa - pb && scaled[ j ] == pa * s[ i + j ] && perp[ j ] == pa.perp( ) &&
+                     same( dot[ j ], pa.dot_product( pb ) ) && same( len[ j ], pa.length( ) );
+
+                const auto ref = pa.normalized( );
+                err = std::fmax( err, std::fabs( static_cast< double >( unit[ j ].x ) - ref.x ) + std::fabs( static_cast< double >( unit[ j ].y ) - ref.y ) );
+            }
+        }
+
+        return ok;
+    }
+}
+
+int main( ) {
+    std::mt19937 gen { 42u };
+    std::uniform_real_distribution<float> dis { -1000.f, 1000.f };
+
+    constexpr size_t count = size_t( 1 ) << 16;
+    std::vector<vec2> points( count + 1 );
+    std::vector<float> factors( count );
+    for ( auto &p : points ) {
+        p = vec2( dis( gen ), dis( gen ) );
+    }
+    for ( auto &f : factors ) {
+        f = dis( gen ) / 1000.f;
+    }
+
+    double err4 = 0.0, err8 = 0.0;
+    const bool ok4 = check<4>( points, factors, err4 );
+    const bool ok8 = check<8>( points, factors, err8 );
+
+    // rsqrt + one Newton step: about 2^-22 off
+    const bool ok = ok4 && ok8 && err4 < 1e-5 && err8 < 1e-5;
+    std::printf( "vec2x4 == vec2: %s, normalise err %.3g\n", ok4 ? "yes" : "NO", err4 );
+    std::printf( "vec2x8 == vec2: %s, normalise err %.3g\n", ok8 ? "yes" : "NO", err8 );
+    std::printf( "batch of the build: %zu lanes\n\n", vec2x_lanes );
+
+    volatile float sink = 0.f;
+    std::vector<vec2> units( count );
+
+    // Length of the polyline through all points
+    const auto len_scalar = points_per_sec( count, [ & ]( ) {
+        float sum = 0.f;
+        for ( size_t i = 0; i < count; ++i ) {
+            sum += ( points[ i + 1 ] - points[ i ] ).length( );
+        }
+        sink = sink + sum;
+    } );
+
+    const auto len_batch = points_per_sec( count, [ & ]( ) {
+        auto sum = f32x8::set( 0.f );
+        for ( size_t i = 0; i < count; i += 8 ) {
+            sum = sum + ( vec2x8::load( points.data( ) + i + 1 ) - vec2x8::load( points.data( ) + i ) ).length( );
+        }
+
+        float lane[ 8 ];
+        sum.store( lane );
+        sink = sink + lane[ 0 ] + lane[ 7 ];
+    } );
+
+    const auto unit_scalar = points_per_sec( count, [ & ]( ) {
+        for ( size_t i = 0; i < count; ++i ) {
+            units[ i ] = points[ i ].normalized( );
+        }
+        sink = sink + units[ count / 2 ].x;
+    } );
+
+    const auto unit_batch = points_per_sec( count, [ & ]( ) {
+        for ( size_t i = 0; i < count; i += 8 ) {
+            vec2x8::load( points.data( ) + i ).normalized( ).store( units.data( ) + i );
+        }
+        sink = sink + units[ count / 2 ].x;
+    } );
+
+    std::printf( "%12s %14s %14s %8s\n", "", "vec2 pts/s", "vec2x8 pts/s", "speedup" );
+    std::printf( "%12s %14.0f %14.0f %7.2fx\n", "link length", len_scalar, len_batch, len_batch / len_scalar );
+    std::printf( "%12s %14.0f %14.0f %7.2fx\n", "normalise", unit_scalar, unit_batch, unit_batch / unit_scalar );
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,416 @@
+// Headless driver: FPL of the main lines + sweep statistics of the charts
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "../fpl/cache.h"
+#include "../fpl/generator.h"
+#include "../fpl/stats.h"
+#include "../fpl/pool.h"
+
+namespace {
+    struct options {
+        fpl::settings cfg;
+
+        // 0 -> one thread per core
+        unsigned threads = 0;
+
+        std::string input;
+        std::string output = "-";
+        std::string stats;
+
+        // Results of earlier runs, none if empty
+        std::string cache;
+
+        // Vertices from the command line, one chain
+        std::vector<vec2> chain;
+    };
+
+    void usage( ) {
+        std::cout <<
+            "Usage: fpl-cli [options] [x,y ...]\n"
+            "\n"
+            "Builds a fractal polyline on the main lines and, optionally, the sweep statistics of the charts.\n"
+            "Main lines are chains of vertices: every vertex after the first adds the segment from the previous one,\n"
+            "a chain that ends on its first vertex is a polygon. Vertices given as arguments make one chain.\n"
+            "\n"
+            "Options:\n"
+            "  -r <int>           recursion depth (default 2)\n"
+            "  -d, --delta <int>  min length of a segment to split (default 2)\n"
+            "  -g, --gen <type>   normal | uniform (default uniform)\n"
+            "      --precision <p> float | double | fixed: scalar the points are made in (default float),\n"
+            "                     double keeps the deep levels (R 16 and more) that float rounds away\n"
+            "                     fixed (16.16) takes coordinates within +-16384 only\n"
+            "      --stddev <f>   normal: standard deviation (default 0.2)\n"
+            "      --j <int>      uniform: s = sj * j (default 30)\n"
+            "      --sj <f>       uniform: step of s (default 0.01)\n"
+            "  -n <int>           realisations per sweep value (default 25), the min of them with --n-max or --tol\n"
+            "      --n-max <int>  adaptive: at most this many realisations per sweep value (default 400)\n"
+            "      --tol <f>      adaptive: stop once the 95% CI of every stat is within tol * its mean (default 0.02)\n"
+            "      --crn <on|off> common random numbers: the same realisations for every sweep value (default off)\n"
+            "      --seed <u64>   seed of the generator (default 1)\n"
+            "  -t, --threads <n>  worker threads for the FPL and the sweeps, 0 = all cores (default 0)\n"
+            "  -i, --input <path> main lines file: \"x y\" per line, an empty line starts a new chain\n"
+            "  -o, --output <p>   FPL, \"x y\" per line, - for stdout (default -)\n"
+            "  -s, --stats <p>    sweep statistics as CSV, - for stdout\n"
+            "      --cache <dir>  keep the FPL and the statistics in dir, runs with the same main lines and settings read them back\n"
+            "  -h, --help         this text\n";
+    }
+
+    bool parse_int( const char *str, int &out ) {
+        char *end = nullptr;
+        errno = 0;
+        const auto v = std::strtol( str, &end, 10 );
+        if ( errno != 0 || end == str || *end != '\0' ) {
+            return false;
+        }
+
+        out = static_cast< int >( v );
+        return true;
+    }
+
+    bool parse_u64( const char *str, uint64_t &out ) {
+        char *end = nullptr;
+        errno = 0;
+        const auto v = std::strtoull( str, &end, 0 );
+        if ( errno != 0 || end == str || *end != '\0' ) {
+            return false;
+        }
+
+        out = static_cast< uint64_t >( v );
+        return true;
+    }
+
+    bool parse_float( const char *str, float &out ) {
+        char *end = nullptr;
+        errno = 0;
+        const auto v = std::strtof( str, &end );
+        if ( errno != 0 || end == str || *end != '\0' ) {
+            return false;
+        }
+
+        out = v;
+        return true;
+    }
+
+    // "x,y"
+    bool parse_point( const char *str, vec2 &out ) {
+        char *end = nullptr;
+        out.x = std::strtof( str, &end );
+        if ( end == str || *end != ',' ) {
+            return false;
+        }
+
+        const char *y = end + 1;
+        out.y = std::strtof( y, &end );
+        return end != y && *end == '\0';
+    }
+
+    // Chain of vertices -> pairs (a, b) of segments, as the canvas makes them
+    void add_chain( const std::vector<vec2> &chain, std::vector<vec2> &points ) {
+        for ( size_t i = 0; i + 1 < chain.size( ); ++i ) {
+            points.push_back( chain[ i ] );
+            points.push_back( chain[ i + 1 ] );
+        }
+    }
+
+    bool read_input( const std::string &path, std::vector<vec2> &points ) {
+        std::ifstream file( path );
+        if ( !file ) {
+            std::cerr << "[error] can't open " << path << std::endl;
+            return false;
+        }
+
+        std::vector<vec2> chain;
+        std::string line;
+        size_t line_n = 0;
+
+        while ( std::getline( file, line ) ) {
+            ++line_n;
+
+            // Comments
+            const auto hash = line.find( '#' );
+            if ( hash != std::string::npos ) {
+                line.resize( hash );
+            }
+
+            std::istringstream ss( line );
+            vec2 p;
+            if ( !( ss >> p.x ) ) {
+                // Empty line -> next chain
+                add_chain( chain, points );
+                chain.clear( );
+                continue;
+            }
+
+            std::string rest;
+            if ( !( ss >> p.y ) || ( ss >> rest ) ) {
+                std::cerr << "[error] " << path << ":" << line_n << ": expected \"x y\"" << std::endl;
+                return false;
+            }
+
+            chain.push_back( p );
+        }
+
+        add_chain( chain, points );
+        return true;
+    }
+
+    // Returns 0 to go on, exit code otherwise
+    int parse_args( int argc, char **argv, options &opt ) {
+        for ( int i = 1; i < argc; ++i ) {
+            const std::string arg = argv[ i ];
+
+            auto is = [ & ]( const char *a, const char *b = nullptr ) {
+                return arg == a || ( b && arg == b );
+            };
+
+            if ( is( "-h", "--help" ) ) {
+                usage( );
+                return -1;
+            }
+
+            // Vertex of the command line chain
+            vec2 p;
+            if ( parse_point( argv[ i ], p ) ) {
+                opt.chain.push_back( p );
+                continue;
+            }
+
+            if ( i + 1 >= argc ) {
+                std::cerr << "[error] unknown or incomplete option " << arg << std::endl;
+                return 1;
+            }
+
+            const char *val = argv[ ++i ];
+            bool ok = true;
+            int threads = 0;
+
+            if ( is( "-r" ) ) {
+                ok = parse_int( val, opt.cfg.r ) && opt.cfg.r >= 0;
+            }
+            else if ( is( "-d", "--delta" ) ) {
+                ok = parse_int( val, opt.cfg.delta );
+            }
+            else if ( is( "-g", "--gen" ) ) {
+                if ( std::strcmp( val, "normal" ) == 0 ) {
+                    opt.cfg.gen_type = fpl::gen_normal;
+                }
+                else if ( std::strcmp( val, "uniform" ) == 0 ) {
+                    opt.cfg.gen_type = fpl::gen_uniform;
+                }
+                else {
+                    ok = false;
+                }
+            }
+            else if ( is( "--precision" ) ) {
+                if ( std::strcmp( val, "float" ) == 0 ) {
+                    opt.cfg.precision = fpl::prec_float;
+                }
+                else if ( std::strcmp( val, "double" ) == 0 ) {
+                    opt.cfg.precision = fpl::prec_double;
+                }
+                else if ( std::strcmp( val, "fixed" ) == 0 ) {
+                    opt.cfg.precision = fpl::prec_fixed;
+                }
+                else {
+                    ok = false;
+                }
+            }
+            else if ( is( "--stddev" ) ) {
+                ok = parse_float( val, opt.cfg.stddev );
+            }
+            else if ( is( "--j" ) ) {
+                ok = parse_int( val, opt.cfg.j );
+            }
+            else if ( is( "--sj" ) ) {
+                ok = parse_float( val, opt.cfg.sj );
+            }
+            else if ( is( "-n" ) ) {
+                ok = parse_int( val, opt.cfg.n ) && opt.cfg.n > 0;
+            }
+            else if ( is( "--n-max" ) ) {
+                ok = parse_int( val, opt.cfg.n_max ) && opt.cfg.n_max > 0;
+                opt.cfg.adaptive = true;
+            }
+            else if ( is( "--tol" ) ) {
+                ok = parse_float( val, opt.cfg.tol ) && opt.cfg.tol > 0.f;
+                opt.cfg.adaptive = true;
+            }
+            else if ( is( "--crn" ) ) {
+                if ( std::strcmp( val, "on" ) == 0 ) {
+                    opt.cfg.crn = true;
+                }
+                else if ( std::strcmp( val, "off" ) == 0 ) {
+                    opt.cfg.crn = false;
+                }
+                else {
+                    ok = false;
+                }
+            }
+            else if ( is( "--seed" ) ) {
+                ok = parse_u64( val, opt.cfg.seed );
+            }
+            else if ( is( "-t", "--threads" ) ) {
+                ok = parse_int( val, threads ) && threads >= 0;
+                opt.threads = static_cast< unsigned >( threads );
+            }
+            else if ( is( "-i", "--input" ) ) {
+                opt.input = val;
+            }
+            else if ( is( "-o", "--output" ) ) {
+                opt.output = val;
+            }
+            else if ( is( "-s", "--stats" ) ) {
+                opt.stats = val;
+            }
+            else if ( is( "--cache" ) ) {
+                opt.cache = val;
+            }
+            else {
+                std::cerr << "[error] unknown option " << arg << std::endl;
+                return 1;
+            }
+
+            if ( !ok ) {
+                std::cerr << "[error] bad value for " << arg << ": " << val << std::endl;
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    // Output file or stdout for "-"
+    std::ostream *open_output( const std::string &path, std::unique_ptr<std::ofstream> &file ) {
+        if ( path == "-" ) {
+            return &std::cout;
+        }
+
+        file = std::make_unique<std::ofstream>( path );
+        if ( !*file ) {
+            std::cerr << "[error] can't write " << path << std::endl;
+            return nullptr;
+        }
+
+        return file.get( );
+    }
+
+    void write_fpl( std::ostream &out, const std::vector<vec2> &fpl ) {
+        char buf[ 64 ];
+        for ( const auto &p : fpl ) {
+            std::snprintf( buf, sizeof( buf ), "%.9g %.9g\n", p.x, p.y );
+            out << buf;
+        }
+    }
+
+    // Charts 1, 2 rows, then chart 3 rows, *_ci are the half widths of the 95% confidence intervals
+    void write_stats( std::ostream &out, const fpl::settings &cfg, const fpl::series &series ) {
+        char buf[ 256 ];
+
+        out << "chart," << ( cfg.gen_type == fpl::gen_normal ? "stddev" : "s" ) << ",max,mean,elong,log2elong,max_ci,mean_ci,elong_ci,log2elong_ci,samples\n";
+        for ( size_t i = 0; i < series.x.size( ); ++i ) {
+            std::snprintf( buf, sizeof( buf ), "1,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d\n",
+                           series.x[ i ], series.max[ i ], series.mean[ i ], series.elong[ i ], series.log2elong[ i ],
+                           series.max_ci[ i ], series.mean_ci[ i ], series.elong_ci[ i ], series.log2elong_ci[ i ], series.samples[ i ] );
+            out << buf;
+        }
+
+        out << "chart,r,,,,log2elong,,,,log2elong_ci,samples\n";
+        for ( size_t i = 0; i < series.x3.size( ); ++i ) {
+            std::snprintf( buf, sizeof( buf ), "3,%d,,,,%.9g,,,,%.9g,%d\n", series.x3[ i ], series.log2elong3[ i ], series.log2elong3_ci[ i ], series.samples3[ i ] );
+            out << buf;
+        }
+    }
+}
+
+int main( int argc, char **argv ) {
+    options opt;
+
+    const auto rc = parse_args( argc, argv, opt );
+    if ( rc != 0 ) {
+        return rc < 0 ? 0 : rc;
+    }
+
+    std::vector<vec2> points;
+
+    if ( !opt.input.empty( ) && !read_input( opt.input, points ) ) {
+        return 1;
+    }
+
+    add_chain( opt.chain, points );
+
+    if ( points.size( ) < 2 ) {
+        std::cerr << "[error] no main lines, give at least two vertices (see --help)" << std::endl;
+        return 1;
+    }
+
+    if ( !fpl::in_range( opt.cfg.precision, points ) ) {
+        std::cerr << "[error] --precision fixed takes coordinates in (-" << fpl::fixed_range << ", " << fpl::fixed_range << ") only" << std::endl;
+        return 1;
+    }
+
+    fpl::pool workers( opt.threads );
+
+    // Nothing is kept in memory, a run asks for every result once
+    fpl::result_cache cache( 0, opt.cache );
+    const bool cached = !opt.cache.empty( );
+
+    // Getting FPL's
+    const auto fpl_key = fpl::fpl_key( points, opt.cfg );
+    std::vector<vec2> fpl_points;
+    if ( !cached || !cache.get( fpl_key, fpl_points ) ) {
+        fpl_points = fpl::do_fpl( points, opt.cfg, &workers );
+        if ( fpl_points.empty( ) ) {
+            std::cerr << "[error] fpls = 0!" << std::endl;
+            return 1;
+        }
+
+        if ( cached ) {
+            cache.put( fpl_key, fpl_points );
+        }
+    }
+
+    std::unique_ptr<std::ofstream> fpl_file;
+    auto *fpl_out = open_output( opt.output, fpl_file );
+    if ( !fpl_out ) {
+        return 1;
+    }
+
+    write_fpl( *fpl_out, fpl_points );
+
+    if ( opt.stats.empty( ) ) {
+        return 0;
+    }
+
+    // Getting stats for charts
+    fpl::series series;
+    const auto stats_key = fpl::stats_key( points, opt.cfg );
+    if ( !cached || !cache.get( stats_key, series ) ) {
+        if ( !fpl::get_stats( points, opt.cfg, series, workers ) ) {
+            return 1;
+        }
+
+        if ( cached ) {
+            cache.put( stats_key, series );
+        }
+    }
+
+    std::unique_ptr<std::ofstream> stats_file;
+    auto *stats_out = open_output( opt.stats, stats_file );
+    if ( !stats_out ) {
+        return 1;
+    }
+
+    write_stats( *stats_out, opt.cfg, series );
+    return 0;
+}
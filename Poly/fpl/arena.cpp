@@ -0,0 +1,67 @@
+#include "arena.h"
+
+namespace fpl {
+    namespace {
+        // First block, the next ones double
+        constexpr size_t min_block = 64 * 1024;
+    }
+
+    size_t arena::capacity( ) const {
+        size_t ret = 0;
+        for ( const auto &b : m_blocks ) {
+            ret += b.size;
+        }
+
+        return ret;
+    }
+
+    arena &arena::local( ) {
+        thread_local arena t_arena;
+        return t_arena;
+    }
+
+    void *arena::do_allocate( size_t bytes, size_t align ) {
+        // Rest of the current block
+        if ( auto *p = take( m_block, bytes, align ) ) {
+            return p;
+        }
+
+        // Next block, made bigger if it can't hold bytes + padding: nothing is allocated there yet
+        const auto next = m_blocks.empty( ) ? 0 : m_block + 1;
+        if ( next == m_blocks.size( ) || m_blocks[ next ].size < bytes + align ) {
+            auto size = m_blocks.empty( ) ? min_block : 2 * m_blocks.back( ).size;
+            while ( size < bytes + align ) {
+                size *= 2;
+            }
+
+            block b { std::unique_ptr<std::byte[ ]>( new std::byte[ size ] ), size };
+            if ( next == m_blocks.size( ) ) {
+                m_blocks.push_back( std::move( b ) );
+            }
+            else {
+                m_blocks[ next ] = std::move( b );
+            }
+        }
+
+        m_block = next;
+        m_used = 0;
+        return take( next, bytes, align );
+    }
+
+    void *arena::take( size_t index, size_t bytes, size_t align ) {
+        if ( index >= m_blocks.size( ) ) {
+            return nullptr;
+        }
+
+        const auto &b = m_blocks[ index ];
+        void *p = b.data.get( ) + m_used;
+        auto space = b.size - m_used;
+
+        if ( !std::align( align, bytes, p, space ) ) {
+            return nullptr;
+        }
+
+        m_used = b.size - space + bytes;
+        return p;
+    }
+}
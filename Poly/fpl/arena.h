@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace fpl {
+    // Monotonic memory for the temporaries of a sweep and of its realisations, one per thread (see local( ))
+    // - allocate bumps a pointer, deallocate does nothing, rewind( ) gives back everything after a mark
+    // - blocks are kept on rewind: once they hold what a sweep needs, it never goes to the heap again
+    class arena : public std::pmr::memory_resource {
+    public:
+        // Where the next allocation starts
+        struct mark {
+            size_t block;
+            size_t used;
+        };
+
+        arena( ) = default;
+
+        arena( const arena & ) = delete;
+        arena &operator=( const arena & ) = delete;
+
+        mark position( ) const {
+            return { m_block, m_used };
+        }
+
+        // Frees everything allocated after m (must be a position( ) not rewound past yet)
+        void rewind( const mark &m ) {
+            m_block = m.block;
+            m_used = m.used;
+        }
+
+        // Bytes held in blocks, used or not
+        size_t capacity( ) const;
+
+        // Arena of the calling thread
+        static arena &local( );
+
+    private:
+        struct block {
+            std::unique_ptr<std::byte[ ]> data;
+            size_t size;
+        };
+
+        void *do_allocate( size_t bytes, size_t align ) override;
+        void do_deallocate( void *, size_t, size_t ) override { }
+
+        // bytes from block index at m_used, nullptr if they don't fit
+        void *take( size_t index, size_t bytes, size_t align );
+
+        bool do_is_equal( const std::pmr::memory_resource &other ) const noexcept override {
+            return this == &other;
+        }
+
+        std::vector<block> m_blocks;
+        size_t m_block = 0;
+        size_t m_used = 0;
+    };
+
+    // Rewinds an arena to where it was when the scope began: containers on resource( ) must die first
+    class arena_scope {
+    public:
+        explicit arena_scope( arena &memory = arena::local( ) ) : m_arena( memory ), m_mark( memory.position( ) ) { }
+
+        ~arena_scope( ) {
+            m_arena.rewind( m_mark );
+        }
+
+        arena_scope( const arena_scope & ) = delete;
+        arena_scope &operator=( const arena_scope & ) = delete;
+
+        std::pmr::memory_resource *resource( ) const {
+            return &m_arena;
+        }
+
+    private:
+        arena &m_arena;
+        arena::mark m_mark;
+    };
+}
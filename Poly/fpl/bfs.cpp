@@ -0,0 +1,46 @@
+#include "bfs.h"
+
+#include "../types/vec2x.h"
+
+namespace fpl {
+    namespace {
+        // d = ( a + b ) / 2 + rf * ( -( b.y - a.y ), b.x - a.x ), the same ops as fpl::generate
+        void refine_scalar( const float *x, const float *y, const float *offsets, size_t first, size_t m, float *nx, float *ny ) {
+            for ( size_t k = first; k < m; ++k ) {
+                const auto ax = x[ k ], ay = y[ k ];
+                const auto bx = x[ k + 1 ], by = y[ k + 1 ];
+                const auto rf = offsets[ k ];
+
+                nx[ 2 * k ] = ax;
+                ny[ 2 * k ] = ay;
+                nx[ 2 * k + 1 ] = ( ax + bx ) * 0.5f - rf * ( by - ay );
+                ny[ 2 * k + 1 ] = ( ay + by ) * 0.5f + rf * ( bx - ax );
+            }
+        }
+    }
+
+    void refine_level( const float *x, const float *y, const float *offsets, size_t m, float *nx, float *ny ) {
+        using lane = f32xn<vec2x_lanes>;
+        using points = vec2xn<vec2x_lanes>;
+
+        size_t k = 0;
+        for ( ; k + vec2x_lanes <= m; k += vec2x_lanes ) {
+            const auto pa = points::load( x + k, y + k );
+            const auto pb = points::load( x + k + 1, y + k + 1 );
+            const auto rf = lane::load( offsets + k );
+
+            // c + rf * perp( b - a ) rounds as c - rf * ( by - ay ) does (no FMA)
+            const auto d = ( pa + pb ) * 0.5f + ( pb - pa ).perp( ) * rf;
+
+            store_zip( nx + 2 * k, pa.x, d.x );
+            store_zip( ny + 2 * k, pa.y, d.y );
+        }
+
+        // Tail
+        refine_scalar( x, y, offsets, k, m, nx, ny );
+
+        // Point b of the last segment
+        nx[ 2 * m ] = x[ m ];
+        ny[ 2 * m ] = y[ m ];
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "engine.h"
+
+namespace fpl {
+    // Scratch of generate_bfs, keep one per thread and reuse it
+    struct bfs_buffers {
+        // Offsets tree in level order: node k of level l is offsets[ 2^l - 1 + k ]
+        std::vector<float> offsets;
+
+        // Points of the current and of the next level (SoA)
+        std::vector<float> x0, y0;
+        std::vector<float> x1, y1;
+    };
+
+    // True if the delta cutoff can't stop any split of ab before depth r
+    // Every split keeps at least half of the length (|ad| = |ab| * sqrt( 1/4 + rf^2 )),
+    // so segments at depth r - 1 are at least |ab| / 2^(r - 1) long
+    inline bool no_cutoff( const vec2 &a, const vec2 &b, int r, int delta ) {
+        if ( r <= 0 || delta <= 0 ) {
+            return true;
+        }
+
+        if ( r > max_depth ) {
+            r = max_depth;
+        }
+
+        // Margin for the rounding of the lengths over the levels
+        const auto min_len = ( b - a ).length( ) * 0.999f / static_cast< float >( size_t( 1 ) << ( r - 1 ) );
+        return min_len >= delta;
+    }
+
+    // One level of midpoint displacement over m segments (m + 1 points of x, y)
+    // Writes 2m + 1 points to nx, ny: the old points at even indices, the new middle ones between them
+    // SSE/AVX2 when the build has them, scalar otherwise, all give the same floats
+    void refine_level( const float *x, const float *y, const float *offsets, size_t m, float *nx, float *ny );
+
+    // Offsets of the nodes of levels 0 .. r - 1 of a tree in level order: node k of level l to offsets[ 2^l - 1 + k ]
+    // - rf( l, first, count, dst ) once per level, rf( l, k ) once per node, or rf( ) in depth-first order
+    template <typename Rf>
+    void fill_offsets( int r, Rf &&rf, float *offsets ) {
+        // Whole levels of offsets at once
+        if constexpr ( std::is_invocable_v<Rf &, int, uint64_t, size_t, float *> ) {
+            for ( int l = 0; l < r; ++l ) {
+                const auto m = size_t( 1 ) << l;
+                rf( l, uint64_t( 0 ), m, offsets + m - 1 );
+            }
+        }
+        // Offsets of the nodes, level by level
+        else if constexpr ( std::is_invocable_v<Rf &, int, uint64_t> ) {
+            for ( int l = 0; l < r; ++l ) {
+                const auto m = size_t( 1 ) << l;
+                for ( size_t k = 0; k < m; ++k ) {
+                    offsets[ m - 1 + k ] = rf( l, k );
+                }
+            }
+        }
+        // Offsets in depth-first order, stored by level
+        else if ( r > 0 ) {
+            struct node {
+                int l;
+                size_t k;
+            };
+
+            node stack[ max_depth + 1 ];
+            int top = 0;
+            stack[ top++ ] = { 0, 0 };
+
+            while ( top > 0 ) {
+                const auto cur = stack[ --top ];
+                offsets[ ( size_t( 1 ) << cur.l ) - 1 + cur.k ] = rf( );
+
+                // Left child goes first
+                if ( cur.l + 1 < r ) {
+                    stack[ top++ ] = { cur.l + 1, cur.k * 2 + 1 };
+                    stack[ top++ ] = { cur.l + 1, cur.k * 2 };
+                }
+            }
+        }
+    }
+
+    // Midpoint displacement of ab refined a whole level at a time, without the delta cutoff
+    // - rf() is called 2^r - 1 times in the order fpl::generate calls it (depth-first),
+    //   or rf( l, k ) once per node in level order,
+    //   or rf( l, first, count, dst ) once per level to fill the offsets of nodes first .. first + count - 1,
+    //   so where no_cutoff( a, b, r, delta ) holds both give the same points
+    // - out must hold at least capacity( r ) points
+    // Returns the count of points written (always capacity( r ))
+    template <typename Rf>
+    size_t generate_bfs( const vec2 &a, const vec2 &b, int r, Rf &&rf, vec2 *out, bfs_buffers &buf ) {
+        if ( r < 0 ) {
+            r = 0;
+        }
+        else if ( r > max_depth ) {
+            r = max_depth;
+        }
+
+        const auto count = capacity( r );
+
+        buf.offsets.resize( count - 1 );
+        fill_offsets( r, rf, buf.offsets.data( ) );
+
+        buf.x0.resize( count );
+        buf.y0.resize( count );
+        buf.x1.resize( count );
+        buf.y1.resize( count );
+
+        float *x = buf.x0.data( ), *y = buf.y0.data( );
+        float *nx = buf.x1.data( ), *ny = buf.y1.data( );
+
+        x[ 0 ] = a.x;
+        y[ 0 ] = a.y;
+        x[ 1 ] = b.x;
+        y[ 1 ] = b.y;
+
+        for ( int l = 0; l < r; ++l ) {
+            const auto m = size_t( 1 ) << l;
+            refine_level( x, y, buf.offsets.data( ) + m - 1, m, nx, ny );
+
+            std::swap( x, nx );
+            std::swap( y, ny );
+        }
+
+        for ( size_t i = 0; i < count; ++i ) {
+            out[ i ] = vec2( x[ i ], y[ i ] );
+        }
+
+        return count;
+    }
+}
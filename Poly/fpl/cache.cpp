@@ -0,0 +1,337 @@
+#include "cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <type_traits>
+
+namespace fpl {
+    namespace {
+        // Bumped when the file layout or the meaning of a key changes
+        constexpr char file_magic[ 4 ] = { 'F', 'P', 'L', 'C' };
+        constexpr uint32_t file_version = 4;
+
+        template <typename T>
+        void append( std::string &key, const T &value ) {
+            static_assert( std::is_trivially_copyable_v<T> );
+            key.append( reinterpret_cast< const char * >( &value ), sizeof( T ) );
+        }
+
+        // Tag, main lines (every point: a hash of them could collide), then the settings every result depends on
+        std::string base_key( const char *tag, const std::vector<vec2> &points, const settings &cfg ) {
+            std::string key = tag;
+            append( key, static_cast< uint64_t >( points.size( ) ) );
+            key.append( reinterpret_cast< const char * >( points.data( ) ), points.size( ) * sizeof( vec2 ) );
+            append( key, cfg.r );
+            append( key, cfg.delta );
+            append( key, cfg.gen_type );
+            append( key, cfg.precision );
+            append( key, cfg.seed );
+            return key;
+        }
+
+        template <typename T>
+        size_t bytes_of( const std::vector<T> &v ) {
+            return v.size( ) * sizeof( T );
+        }
+
+        // Every vector of a series, in the file order
+        template <typename S, typename Fn>
+        void each_vector( S &stats, Fn &&fn ) {
+            fn( stats.x );
+            fn( stats.max );
+            fn( stats.mean );
+            fn( stats.elong );
+            fn( stats.log2elong );
+            fn( stats.max_ci );
+            fn( stats.mean_ci );
+            fn( stats.elong_ci );
+            fn( stats.log2elong_ci );
+            fn( stats.samples );
+            fn( stats.x3 );
+            fn( stats.log2elong3 );
+            fn( stats.log2elong3_ci );
+            fn( stats.samples3 );
+        }
+
+        size_t bytes_of( const series &stats ) {
+            size_t ret = 0;
+            each_vector( stats, [ & ]( const auto &v ) { ret += bytes_of( v ); } );
+            return ret;
+        }
+
+        template <typename T>
+        void write_vector( std::ostream &out, const std::vector<T> &v ) {
+            const auto count = static_cast< uint64_t >( v.size( ) );
+            out.write( reinterpret_cast< const char * >( &count ), sizeof( count ) );
+            out.write( reinterpret_cast< const char * >( v.data( ) ), static_cast< std::streamsize >( bytes_of( v ) ) );
+        }
+
+        template <typename T>
+        bool read_vector( std::istream &in, uint64_t left, std::vector<T> &v ) {
+            uint64_t count = 0;
+            if ( !in.read( reinterpret_cast< char * >( &count ), sizeof( count ) ) || count > left / sizeof( T ) ) {
+                return false;
+            }
+
+            v.resize( static_cast< size_t >( count ) );
+            return static_cast< bool >( in.read( reinterpret_cast< char * >( v.data( ) ), static_cast< std::streamsize >( bytes_of( v ) ) ) );
+        }
+    }
+
+    uint64_t hash_bytes( const void *data, size_t size, uint64_t h ) {
+        const auto *p = static_cast< const unsigned char * >( data );
+        for ( size_t i = 0; i < size; ++i ) {
+            h ^= p[ i ];
+            h *= 1099511628211ull;
+        }
+
+        return h;
+    }
+
+    std::string fpl_key( const std::vector<vec2> &points, const settings &cfg ) {
+        auto key = base_key( "fpl", points, cfg );
+
+        // do_fpl reads the parameter of its generator only
+        append( key, cfg.gen_type == gen_normal ? cfg.stddev : cfg.s( ) );
+        return key;
+    }
+
+    std::string stats_key( const std::vector<vec2> &points, const settings &cfg ) {
+        auto key = base_key( "stats", points, cfg );
+        append( key, cfg.n );
+        append( key, cfg.crn );
+
+        append( key, cfg.adaptive );
+        if ( cfg.adaptive ) {
+            append( key, cfg.n_max );
+            append( key, cfg.tol );
+        }
+
+        // Uniform sweeps over sj * 1..j, normal over 0.01..stddev
+        if ( cfg.gen_type == gen_normal ) {
+            append( key, cfg.stddev );
+        }
+        else {
+            append( key, cfg.j );
+            append( key, cfg.sj );
+        }
+
+        return key;
+    }
+
+    result_cache::result_cache( size_t budget, std::string dir ) : m_budget( budget ), m_dir( std::move( dir ) ) {
+        if ( m_dir.empty( ) ) {
+            return;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories( m_dir, ec );
+        if ( ec ) {
+            std::cout << "[error] can't make cache dir " << m_dir << ": " << ec.message( ) << " Line: " << __LINE__ << std::endl;
+            m_dir.clear( );
+        }
+    }
+
+    bool result_cache::get( const std::string &key, std::vector<vec2> &out ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mtx );
+            if ( const auto *e = find( key ) ) {
+                out = e->fpl;
+                return true;
+            }
+        }
+
+        // Not in memory, maybe on disk (read with no lock held)
+        entry e;
+        if ( !load( key, e ) ) {
+            return false;
+        }
+
+        out = e.fpl;
+
+        std::lock_guard<std::mutex> lock( m_mtx );
+        insert( std::move( e ) );
+        return true;
+    }
+
+    bool result_cache::get( const std::string &key, series &out ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mtx );
+            if ( const auto *e = find( key ) ) {
+                out = e->stats;
+                return true;
+            }
+        }
+
+        // Not in memory, maybe on disk (read with no lock held)
+        entry e;
+        if ( !load( key, e ) ) {
+            return false;
+        }
+
+        out = e.stats;
+
+        std::lock_guard<std::mutex> lock( m_mtx );
+        insert( std::move( e ) );
+        return true;
+    }
+
+    void result_cache::put( const std::string &key, const std::vector<vec2> &fpl ) {
+        entry e;
+        e.key = key;
+        e.fpl = fpl;
+        e.bytes = key.size( ) + bytes_of( fpl );
+
+        // The file is written with no lock held: get( ) doesn't wait for the disk
+        store( e );
+
+        std::lock_guard<std::mutex> lock( m_mtx );
+        insert( std::move( e ) );
+    }
+
+    void result_cache::put( const std::string &key, const series &stats ) {
+        entry e;
+        e.key = key;
+        e.stats = stats;
+        e.bytes = key.size( ) + bytes_of( stats );
+
+        // The file is written with no lock held: get( ) doesn't wait for the disk
+        store( e );
+
+        std::lock_guard<std::mutex> lock( m_mtx );
+        insert( std::move( e ) );
+    }
+
+    size_t result_cache::bytes( ) {
+        std::lock_guard<std::mutex> lock( m_mtx );
+        return m_bytes;
+    }
+
+    void result_cache::clear( ) {
+        std::lock_guard<std::mutex> lock( m_mtx );
+        m_lru.clear( );
+        m_index.clear( );
+        m_bytes = 0;
+    }
+
+    result_cache::entry *result_cache::find( const std::string &key ) {
+        const auto it = m_index.find( key );
+        if ( it == m_index.end( ) ) {
+            return nullptr;
+        }
+
+        m_lru.splice( m_lru.begin( ), m_lru, it->second );
+        return &m_lru.front( );
+    }
+
+    void result_cache::insert( entry &&e ) {
+        if ( e.bytes > m_budget ) {
+            return;
+        }
+
+        // The same key again replaces the old result
+        const auto it = m_index.find( e.key );
+        if ( it != m_index.end( ) ) {
+            m_bytes -= it->second->bytes;
+            m_lru.erase( it->second );
+            m_index.erase( it );
+        }
+
+        m_bytes += e.bytes;
+        m_lru.push_front( std::move( e ) );
+        m_index[ m_lru.front( ).key ] = m_lru.begin( );
+
+        while ( m_bytes > m_budget ) {
+            auto &last = m_lru.back( );
+            m_bytes -= last.bytes;
+            m_index.erase( last.key );
+            m_lru.pop_back( );
+        }
+    }
+
+    std::string result_cache::path_of( const std::string &key ) const {
+        char name[ 32 ];
+        std::snprintf( name, sizeof( name ), "%016llx.fplc", static_cast< unsigned long long >( hash_bytes( key.data( ), key.size( ) ) ) );
+        return ( std::filesystem::path( m_dir ) / name ).string( );
+    }
+
+    bool result_cache::load( const std::string &key, entry &out ) const {
+        if ( m_dir.empty( ) ) {
+            return false;
+        }
+
+        const auto path = path_of( key );
+        std::ifstream in( path, std::ios::binary );
+        if ( !in ) {
+            return false;
+        }
+
+        std::error_code ec;
+        const auto size = std::filesystem::file_size( path, ec );
+        if ( ec ) {
+            return false;
+        }
+
+        // A file of another version, or of another key with the same file name (hash of the key), is a miss
+        char magic[ 4 ] = { };
+        uint32_t version = 0;
+        std::vector<char> stored;
+        if ( !in.read( magic, sizeof( magic ) ) || std::memcmp( magic, file_magic, sizeof( magic ) ) != 0 ||
+             !in.read( reinterpret_cast< char * >( &version ), sizeof( version ) ) || version != file_version ||
+             !read_vector( in, size, stored ) || std::string( stored.begin( ), stored.end( ) ) != key ) {
+            return false;
+        }
+
+        entry e;
+        e.key = key;
+        if ( !read_vector( in, size, e.fpl ) ) {
+            return false;
+        }
+
+        bool ok = true;
+        each_vector( e.stats, [ & ]( auto &v ) { ok = ok && read_vector( in, size, v ); } );
+        if ( !ok ) {
+            return false;
+        }
+
+        e.bytes = key.size( ) + bytes_of( e.fpl ) + bytes_of( e.stats );
+        out = std::move( e );
+        return true;
+    }
+
+    void result_cache::store( const entry &e ) const {
+        if ( m_dir.empty( ) ) {
+            return;
+        }
+
+        // Written aside, then renamed: readers never see half a file, even from other processes
+        const auto path = path_of( e.key );
+        const auto tmp = path + "." + std::to_string( std::random_device { }( ) ) + ".tmp";
+        {
+            std::ofstream out( tmp, std::ios::binary );
+            out.write( file_magic, sizeof( file_magic ) );
+            out.write( reinterpret_cast< const char * >( &file_version ), sizeof( file_version ) );
+            write_vector( out, std::vector<char>( e.key.begin( ), e.key.end( ) ) );
+            write_vector( out, e.fpl );
+            each_vector( e.stats, [ & ]( const auto &v ) { write_vector( out, v ); } );
+
+            if ( !out ) {
+                std::cout << "[error] can't write " << tmp << " Line: " << __LINE__ << std::endl;
+                out.close( );
+                std::remove( tmp.c_str( ) );
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename( tmp, path, ec );
+        if ( ec ) {
+            std::cout << "[error] can't write " << path << ": " << ec.message( ) << " Line: " << __LINE__ << std::endl;
+            std::filesystem::remove( tmp, ec );
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "generator.h"
+#include "stats.h"
+
+namespace fpl {
+    // 64-bit FNV-1a of the bytes
+    uint64_t hash_bytes( const void *data, size_t size, uint64_t h = 14695981039346656037ull );
+
+    // Keys of the results: the main lines + the settings the result depends on, nothing else
+    // (N doesn't change the FPL, stddev doesn't change uniform stats...)
+    std::string fpl_key( const std::vector<vec2> &points, const settings &cfg );
+    std::string stats_key( const std::vector<vec2> &points, const settings &cfg );
+
+    // LRU cache of FPL's and sweep series, the least recently used go once the budget (bytes) is full
+    // - results bigger than the budget aren't kept
+    // - dir not empty: every result also goes to a file there and misses are looked up in them,
+    //   so repeated CLI / batch runs get them back from disk
+    // - thread safe, files are read and written with no lock held
+    class result_cache {
+    public:
+        explicit result_cache( size_t budget = size_t( 256 ) << 20, std::string dir = { } );
+
+        result_cache( const result_cache & ) = delete;
+        result_cache &operator=( const result_cache & ) = delete;
+
+        // False on a miss, out is left as it was then
+        bool get( const std::string &key, std::vector<vec2> &out );
+        bool get( const std::string &key, series &out );
+
+        void put( const std::string &key, const std::vector<vec2> &fpl );
+        void put( const std::string &key, const series &stats );
+
+        // Bytes of the results in memory
+        size_t bytes( );
+
+        // Drops everything in memory, the files stay
+        void clear( );
+
+    private:
+        struct entry {
+            std::string key;
+            std::vector<vec2> fpl;
+            series stats;
+            size_t bytes = 0;
+        };
+
+        using lru = std::list<entry>;
+
+        // Moves the entry of key to the front, nullptr if it isn't in memory
+        entry *find( const std::string &key );
+
+        // Front of the list, then drops the oldest ones until the budget is met
+        void insert( entry &&e );
+
+        // File of key in m_dir
+        std::string path_of( const std::string &key ) const;
+
+        bool load( const std::string &key, entry &out ) const;
+        void store( const entry &e ) const;
+
+        size_t m_budget;
+        std::string m_dir;
+
+        std::mutex m_mtx;
+
+        // Guarded by m_mtx, most recent first
+        lru m_lru;
+        std::unordered_map<std::string, lru::iterator> m_index;
+        size_t m_bytes = 0;
+    };
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "../types/vec2.h"
+
+namespace fpl {
+    // Deepest recursion the engine can walk (size of its fixed stack)
+    constexpr int max_depth = 30;
+
+    // Max count of points produced for one segment: 2^r + 1
+    // The delta cutoff can only make it smaller
+    constexpr size_t capacity( int r ) {
+        if ( r < 0 ) {
+            r = 0;
+        }
+        else if ( r > max_depth ) {
+            r = max_depth;
+        }
+
+        return ( size_t( 1 ) << r ) + 1;
+    }
+
+    // Offset of node k of level l ( rf( l, k ) ) or the next offset of a sequence ( rf( ) )
+    template <typename Rf>
+    float call_rf( Rf &rf, int l, uint64_t k ) {
+        if constexpr ( std::is_invocable_v<Rf &, int, uint64_t> ) {
+            return rf( l, k );
+        }
+        else {
+            return rf( );
+        }
+    }
+
+    // Midpoint displacement of the segment ab, every point goes to visit( point ) as soon as it's made
+    // - rf() returns the offset of the next middle point,
+    //   or rf( l, k ) the offset of node k of level l (then the walk order doesn't matter)
+    // Walks the tree in the same order as the old recursive FPLrec (a first, then d -> b),
+    // so for the same sequence of rf() it gives the same points. O( r ) memory, no heap allocations.
+    // Returns the count of points visited (a first, b last)
+    // Points are basic_vec2<T>, every level is rounded to T (see precision)
+    template <typename T, typename Rf, typename Visit>
+    size_t generate_each( const basic_vec2<T> &a, const basic_vec2<T> &b, int r, int delta, Rf &&rf, Visit &&visit ) {
+        using point = basic_vec2<T>;
+
+        struct node {
+            point b;
+            int r;
+            int l;
+            uint64_t k;
+        };
+
+        if ( r < 0 ) {
+            r = 0;
+        }
+        else if ( r > max_depth ) {
+            r = max_depth;
+        }
+
+        // Pending right ends of the segments, at most one per level
+        node stack[ max_depth + 1 ];
+        int top = 0;
+
+        size_t count = 1;
+        auto last = a;
+        visit( last );
+        stack[ top++ ] = { b, r, 0, 0 };
+
+        while ( top > 0 ) {
+            const auto cur = stack[ --top ];
+
+            auto vec_a = last;
+            auto vec_b = cur.b;
+
+            // Getting the length of the segment ab
+            auto vec_v = vec_b - vec_a;
+            auto v_len = vec_v.length( );
+
+            // Recursion stop condition
+            if ( cur.r == 0 || v_len < delta ) {
+                last = vec_b;
+                visit( last );
+                ++count;
+                continue;
+            }
+
+            // Middle point
+            auto c = ( vec_a + vec_b ) / 2;
+
+            // Middle points offset (ab rotated by exactly 90 degrees)
+            auto rotv = vec_v.perp( );
+            auto rf_v = call_rf( rf, cur.l, cur.k );
+            auto d = point( c.x + rf_v * rotv.x, c.y + rf_v * rotv.y );
+
+            // Segment db goes after ad
+            stack[ top++ ] = { vec_b, cur.r - 1, cur.l + 1, cur.k * 2 + 1 };
+            stack[ top++ ] = { d, cur.r - 1, cur.l + 1, cur.k * 2 };
+        }
+
+        return count;
+    }
+
+    // generate_each into the caller's buffer, out must hold at least capacity( r ) points
+    // Returns the count of points written (out[ 0 ] = a, out[ count - 1 ] = b)
+    template <typename T, typename Rf>
+    size_t generate( const basic_vec2<T> &a, const basic_vec2<T> &b, int r, int delta, Rf &&rf, basic_vec2<T> *out ) {
+        size_t count = 0;
+        return generate_each( a, b, r, delta, rf, [ & ]( const basic_vec2<T> &point ) { out[ count++ ] = point; } );
+    }
+
+    // Points [first, first + count) of the full tree of ab (no delta cutoff), point i of capacity( r )
+    // - rf( l, k ) gives the offset of node k of level l, so any range (or a single point)
+    //   comes out the same as the matching part of generate( a, b, r, 0, rf, ... ), in any order or thread
+    // - level l of the tree is generate_range( a, b, l, 0, capacity( l ), ... ): levels share their offsets
+    // Only the subtrees over the range are split: O( r + count )
+    // Returns the count of points written
+    template <typename T, typename Rf>
+    size_t generate_range( const basic_vec2<T> &a, const basic_vec2<T> &b, int r, size_t first, size_t count, Rf &&rf, basic_vec2<T> *out ) {
+        using point = basic_vec2<T>;
+
+        struct node {
+            point b;
+            int l;
+            uint64_t k;
+        };
+
+        if ( r < 0 ) {
+            r = 0;
+        }
+        else if ( r > max_depth ) {
+            r = max_depth;
+        }
+
+        const auto total = capacity( r );
+        if ( first >= total ) {
+            return 0;
+        }
+
+        const auto end = first + count < total ? first + count : total;
+
+        node stack[ max_depth + 1 ];
+        int top = 0;
+
+        size_t written = 0;
+        if ( first == 0 ) {
+            out[ written++ ] = a;
+        }
+
+        // Left point of the current node and its index
+        auto last = a;
+        size_t pos = 0;
+
+        stack[ top++ ] = { b, 0, 0 };
+
+        while ( top > 0 && pos + 1 < end ) {
+            const auto cur = stack[ --top ];
+            const auto span = size_t( 1 ) << ( r - cur.l );
+
+            // Nothing of the range inside -> only its right end matters
+            if ( cur.l == r || pos + span <= first ) {
+                last = cur.b;
+                pos += span;
+
+                if ( pos >= first && pos < end ) {
+                    out[ written++ ] = last;
+                }
+
+                continue;
+            }
+
+            auto vec_v = cur.b - last;
+            auto c = ( last + cur.b ) / 2;
+
+            // Middle points offset (ab rotated by exactly 90 degrees)
+            auto rotv = vec_v.perp( );
+            auto rf_v = rf( cur.l, cur.k );
+            auto d = point( c.x + rf_v * rotv.x, c.y + rf_v * rotv.y );
+
+            stack[ top++ ] = { cur.b, cur.l + 1, cur.k * 2 + 1 };
+            stack[ top++ ] = { d, cur.l + 1, cur.k * 2 };
+        }
+
+        return written;
+    }
+
+    // Scalar an FPL is made, compacted and summed in, picked per run (see do_fpl_in, do_stat_in)
+    // - float: the SIMD level kernels and sums, but every level is rounded to float and the errors of the levels
+    //   above add up (about 8 ulps off at R 24 on a canvas-sized segment), so do the float sums of the links
+    // - double: the points and the sums in double, rounded to float only for drawing
+    // - fixed: 16.16 points (fixed32), the same 2^-16 step on the whole canvas, summed in double
+    // bench_precision compares them against long double
+    enum precision : int {
+        prec_float = 0,
+        prec_double = 1,
+        prec_fixed = 2,
+    };
+
+    // Coordinates the fixed scalar takes: a + b of a midpoint must fit in 16.16 too, so half its range
+    // (further out it saturates, see fixed32)
+    constexpr float fixed_range = 16384.f;
+}
@@ -0,0 +1,309 @@
+#include "generator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "engine.h"
+#include "bfs.h"
+#include "philox.h"
+#include "sampler.h"
+#include "unrolled.h"
+
+namespace fpl {
+    float get_rf( int gen_type, float stddev, float s, const rng::node_key &key, int l, uint64_t k ) {
+        float ret = 0.f;
+
+        // Normal dist
+        if ( gen_type == gen_normal ) {
+            ret = stddev * rng::unit_normal( key, l, k );
+        }
+        // Uniform dist
+        else if ( gen_type == gen_uniform ) {
+            ret = s * rng::unit_uniform( key, l, k );
+        }
+
+        return ret;
+    }
+
+    float segment_rf::operator()( int l, uint64_t k ) const {
+        return get_rf( gen_type, stddev, s, key, l, k );
+    }
+
+    void segment_rf::operator()( int l, uint64_t first, size_t count, float *out ) const {
+        if ( gen_type == gen_normal ) {
+            rng::fill_normal( key, l, first, count, stddev, out );
+        }
+        else if ( gen_type == gen_uniform ) {
+            rng::fill_uniform( key, l, first, count, s, out );
+        }
+        else {
+            std::fill( out, out + count, 0.f );
+        }
+    }
+
+    bool is_main_link( const std::vector<vec2> &points, const vec2 &point, const vec2 &next ) {
+        // Search the main points ab
+        auto it_a = std::find( points.begin( ), points.end( ), point );
+        auto it_b = std::find( points.begin( ), points.end( ), next );
+
+        if ( it_a == points.end( ) || it_b == points.end( ) ) {
+            return false;
+        }
+
+        // Inc iterator a to get it equal to it_b
+        it_a++;
+
+        return it_a != points.end( ) && it_a == it_b;
+    }
+
+    template <typename T>
+    basic_main_index<T>::basic_main_index( const point *points, size_t count, std::pmr::memory_resource *memory )
+        : m_points( points ), m_count( count ), m_slots( memory ), m_filter( memory ) {
+        // Load of 1/2 at most: a point that isn't a main one (almost every FPL point) mostly hits an empty slot
+        size_t size = 16;
+        while ( size < 2 * count ) {
+            size *= 2;
+        }
+
+        m_slots.assign( size, 0 );
+        m_mask = size - 1;
+
+        // 16 bits of the filter per point at least, 4096 of them (512 bytes) for a few
+        size_t bits = 4096;
+        m_filter_shift = 64 - 12;
+        while ( bits < 16 * count ) {
+            bits *= 2;
+            --m_filter_shift;
+        }
+
+        m_filter.assign( bits / 64, 0 );
+
+        // Only the first of equal points, as std::find finds it
+        for ( size_t i = 0; i < count; ++i ) {
+            if ( first_of( points[ i ] ) != count ) {
+                continue;
+            }
+
+            auto slot = slot_of( points[ i ] );
+            while ( m_slots[ slot ] != 0 ) {
+                slot = ( slot + 1 ) & m_mask;
+            }
+
+            m_slots[ slot ] = static_cast< uint32_t >( i + 1 );
+
+            const auto f = filter_of( points[ i ] );
+            m_filter[ f / 64 ] |= uint64_t( 1 ) << ( f % 64 );
+        }
+    }
+
+    template <typename T>
+    bool basic_main_index<T>::link_of( const point &p, const point &next ) const {
+        const auto ia = first_of( p );
+        if ( ia == m_count ) {
+            return false;
+        }
+
+        const auto ib = first_of( next );
+        return ib != m_count && ib == ia + 1;
+    }
+
+    template <typename T>
+    size_t basic_main_index<T>::first_of( const point &p ) const {
+        for ( auto slot = slot_of( p ); m_slots[ slot ] != 0; slot = ( slot + 1 ) & m_mask ) {
+            const auto i = m_slots[ slot ] - 1;
+            if ( m_points[ i ] == p ) {
+                return i;
+            }
+        }
+
+        return m_count;
+    }
+
+    template <typename T>
+    size_t basic_main_index<T>::slot_of( const point &p ) const {
+        // 64-bit mix (splitmix64 finalizer)
+        uint64_t h = key_of( p );
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        h ^= h >> 31;
+
+        return static_cast< size_t >( h ) & m_mask;
+    }
+
+    namespace {
+        // compact_run over the points at( 0 .. count ), written to out (may be where they are read from: dst never overtakes src)
+        template <typename T, typename At>
+        size_t compact_points( const basic_main_index<T> &mains, const basic_vec2<T> *prev, At &&at, size_t count, basic_vec2<T> *out ) {
+            // Processing FPL points
+            size_t dst = 0;
+            for ( size_t n = 0; n < count; ++n ) {
+                const auto point = at( n );
+
+                // It's a last coord (point b)
+                if ( n + 1 >= count ) {
+                    out[ dst++ ] = point;
+                    break;
+                }
+
+                // If we have the same coords: src(x,y) = dst(x,y) -> skip
+                const auto *last = dst > 0 ? &out[ dst - 1 ] : prev;
+                if ( last && *last == point ) {
+                    continue;
+                }
+
+                // !Probably never called here!
+                // Skip if its points from a main lines
+                if ( mains.is_link( point, at( n + 1 ) ) ) {
+                    continue;
+                }
+
+                out[ dst++ ] = point;
+            }
+
+            return dst;
+        }
+    }
+
+    template <typename T>
+    size_t compact_run( const basic_main_index<T> &mains, const basic_vec2<T> *prev, basic_vec2<T> *run, size_t count ) {
+        return compact_points( mains, prev, [ run ]( size_t n ) { return run[ n ]; }, count, run );
+    }
+
+    size_t compact_run( const main_index &mains, const vec2 *prev, const float *x, const float *y, size_t count, vec2 *out ) {
+        return compact_points( mains, prev, [ x, y ]( size_t n ) { return vec2( x[ n ], y[ n ] ); }, count, out );
+    }
+
+    template <typename T>
+    void pack_runs( std::vector<basic_vec2<T>> &fpl, const std::vector<size_t> &first, const std::vector<size_t> &count, std::vector<size_t> *ends ) {
+        if ( ends ) {
+            ends->clear( );
+        }
+
+        // Every run moves left (or stays), in order nothing is overwritten before it's moved
+        size_t dst = 0;
+        for ( size_t i = 0; i < first.size( ); ++i ) {
+            if ( first[ i ] != dst ) {
+                std::copy( fpl.begin( ) + first[ i ], fpl.begin( ) + first[ i ] + count[ i ], fpl.begin( ) + dst );
+            }
+
+            dst += count[ i ];
+
+            // Point b is always kept
+            if ( ends ) {
+                ends->push_back( dst - 1 );
+            }
+        }
+
+        fpl.resize( dst );
+    }
+
+    template class basic_main_index<float>;
+    template class basic_main_index<double>;
+    template class basic_main_index<fixed32>;
+
+    template size_t compact_run( const main_index &, const vec2 *, vec2 *, size_t );
+    template size_t compact_run( const basic_main_index<double> &, const vec2d *, vec2d *, size_t );
+    template size_t compact_run( const basic_main_index<fixed32> &, const vec2q *, vec2q *, size_t );
+
+    template void pack_runs( std::vector<vec2> &, const std::vector<size_t> &, const std::vector<size_t> &, std::vector<size_t> * );
+    template void pack_runs( std::vector<vec2d> &, const std::vector<size_t> &, const std::vector<size_t> &, std::vector<size_t> * );
+    template void pack_runs( std::vector<vec2q> &, const std::vector<size_t> &, const std::vector<size_t> &, std::vector<size_t> * );
+
+    std::vector<vec2> do_fpl( const std::vector<vec2> &points, int r, int delta, int gen_type, float stddev, float s, uint64_t seed, uint64_t stream,
+                              std::vector<size_t> *ends, pool *workers, int prec ) {
+        // Other scalars: made and compacted in theirs, rounded for drawing only
+        auto rounded = [ ]( const auto &fpl ) {
+            std::vector<vec2> ret( fpl.size( ) );
+            for ( size_t n = 0; n < fpl.size( ); ++n ) {
+                ret[ n ] = vec2( fpl[ n ] );
+            }
+
+            return ret;
+        };
+
+        if ( prec == prec_double ) {
+            return rounded( do_fpl_in<double>( points, r, delta, gen_type, stddev, s, seed, stream, ends, workers ) );
+        }
+        else if ( prec == prec_fixed ) {
+            return rounded( do_fpl_in<fixed32>( points, r, delta, gen_type, stddev, s, seed, stream, ends, workers ) );
+        }
+
+        const auto segments = points.size( ) / 2;
+        const auto slot = capacity( r );
+
+        // Every main segment is generated and compacted in its own slot, then the slots are packed
+        std::vector<vec2> fpl( segments * slot );
+        std::vector<size_t> first( segments ), count( segments );
+
+        // Tasks of about 16k points
+        const auto block = ( size_t( 1 ) << 14 ) / slot;
+        const main_index mains( points );
+
+        parallel_for( workers, segments, block, [ & ]( size_t i ) {
+            const auto vec_a = points[ 2 * i ]; // Point a
+            const auto vec_b = points[ 2 * i + 1 ]; // Point b
+
+            // Same seed and stream -> same FPL, every node has its own offset
+            const segment_rf rf { gen_type, stddev, s, { seed, stream, segment_id( vec_a, vec_b ) } };
+
+            // Scratch of the level by level path, kept between calls
+            thread_local bfs_buffers t_bfs;
+
+            auto *out = fpl.data( ) + i * slot;
+
+            // Float: unrolled or level by level where the cutoff can't hit, all paths give the same points
+            size_t n = 0;
+            if ( !no_cutoff( vec_a, vec_b, r, delta ) ) {
+                n = generate( vec_a, vec_b, r, delta, rf, out );
+            }
+            else if ( r <= unrolled_cutoff ) {
+                n = generate_unrolled( vec_a, vec_b, r, rf, out );
+            }
+            else {
+                n = generate_bfs( vec_a, vec_b, r, rf, out, t_bfs );
+            }
+
+            first[ i ] = i * slot;
+            count[ i ] = compact_run( mains, seam_point( points, i ), out, n );
+        } );
+
+        pack_runs( fpl, first, count, ends );
+        return fpl;
+    }
+
+    template <typename T>
+    std::vector<basic_vec2<T>> do_fpl_in( const std::vector<vec2> &points, int r, int delta, int gen_type, float stddev, float s, uint64_t seed,
+                                          uint64_t stream, std::vector<size_t> *ends, pool *workers ) {
+        using point = basic_vec2<T>;
+
+        const auto segments = points.size( ) / 2;
+        const auto slot = capacity( r );
+
+        // The main points in T, the same slots and packing as do_fpl
+        std::vector<point> mains_t( points.begin( ), points.end( ) );
+        std::vector<point> fpl( segments * slot );
+        std::vector<size_t> first( segments ), count( segments );
+
+        const auto block = ( size_t( 1 ) << 14 ) / slot;
+        const basic_main_index<T> mains( mains_t );
+
+        parallel_for( workers, segments, block, [ & ]( size_t i ) {
+            const segment_rf rf { gen_type, stddev, s, { seed, stream, segment_id( points[ 2 * i ], points[ 2 * i + 1 ] ) } };
+
+            auto *out = fpl.data( ) + i * slot;
+            const auto n = generate( mains_t[ 2 * i ], mains_t[ 2 * i + 1 ], r, delta, rf, out );
+
+            first[ i ] = i * slot;
+            count[ i ] = compact_run( mains, i > 0 ? &mains_t[ 2 * i - 1 ] : nullptr, out, n );
+        } );
+
+        pack_runs( fpl, first, count, ends );
+        return fpl;
+    }
+
+    template std::vector<vec2d> do_fpl_in( const std::vector<vec2> &, int, int, int, float, float, uint64_t, uint64_t, std::vector<size_t> *, pool * );
+    template std::vector<vec2q> do_fpl_in( const std::vector<vec2> &, int, int, int, float, float, uint64_t, uint64_t, std::vector<size_t> *, pool * );
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "engine.h"
+#include "philox.h"
+#include "pool.h"
+
+namespace fpl {
+    // Generator type of the middle points offsets
+    enum gen_type : int {
+        gen_normal = 0,  // N(0, stddev)
+        gen_uniform = 1, // U(-s, s)
+    };
+
+    // Everything that defines one FPL and its charts
+    struct settings {
+        int r = 2;
+        int delta = 2;
+
+        // Realisations per sweep value
+        int n = 25;
+
+        // Adaptive: n at least, then n more at a time until the 95% CI of every stat of the value
+        // is within tol * its mean, n_max at most
+        bool adaptive = false;
+        int n_max = 400;
+        float tol = 0.02f;
+
+        // Common random numbers: every sweep value (and every depth of chart 3) gets the same
+        // realisations, only scaled, so neighbouring points of the charts differ by the value alone
+        bool crn = false;
+
+        int gen_type = gen_uniform;
+
+        // Scalar the points are made in (see fpl::precision)
+        int precision = prec_float;
+
+        // Same seed -> same FPL and charts
+        uint64_t seed = 1;
+
+        // Normal dist
+        float stddev = 0.2f;
+
+        // Uniform dist: s = sj * j
+        int j = 30;
+        float sj = 0.01f;
+
+        float s( ) const {
+            return j * sj;
+        }
+    };
+
+    // Key of the tree of main segment a, b (rng::node_key::segment): a hash of a and b alone, so a segment
+    // keeps its offsets when others are added, moved or dropped before it; the same a, b twice get the same tree
+    inline uint32_t segment_id( const vec2 &a, const vec2 &b ) {
+        // -0 == 0, both hash as 0
+        auto bits = [ ]( float v ) {
+            v = v == 0.f ? 0.f : v;
+
+            uint32_t ret = 0;
+            std::memcpy( &ret, &v, sizeof( v ) );
+            return static_cast< uint64_t >( ret );
+        };
+
+        // 64-bit mix (splitmix64 finalizer)
+        auto mix = [ ]( uint64_t h ) {
+            h ^= h >> 30;
+            h *= 0xbf58476d1ce4e5b9ull;
+            h ^= h >> 27;
+            h *= 0x94d049bb133111ebull;
+            return h ^ ( h >> 31 );
+        };
+
+        const auto h = mix( mix( ( bits( a.x ) << 32 ) | bits( a.y ) ) ^ ( ( bits( b.x ) << 32 ) | bits( b.y ) ) );
+        return static_cast< uint32_t >( h ^ ( h >> 32 ) );
+    }
+
+    // Offset of node k of level l of the tree keyed by key (counter-based, see rng::philox4x32)
+    // Depends only on its arguments, so nodes can be made in any order and on any thread
+    float get_rf( int gen_type, float stddev, float s, const rng::node_key &key, int l, uint64_t k );
+
+    // Offsets of one main segment: rf( l, k ) for one node (fpl::generate),
+    // rf( l, first, count, out ) for a run of nodes of a level (fpl::generate_bfs, SIMD)
+    struct segment_rf {
+        int gen_type;
+        float stddev;
+        float s;
+        rng::node_key key;
+
+        float operator()( int l, uint64_t k ) const;
+        void operator()( int l, uint64_t first, size_t count, float *out ) const;
+    };
+
+    // True if point and next are main points that follow each other in points (do_fpl drops point then)
+    // Linear in the count of main points, main_index answers the same in O( 1 )
+    bool is_main_link( const std::vector<vec2> &points, const vec2 &point, const vec2 &next );
+
+    // Main points hashed by value (open addressing), built once per FPL
+    // Points of T: the main points in the scalar the FPL is made in (see do_fpl_in)
+    // The points (and memory, the slots are there) must outlive it
+    template <typename T>
+    class basic_main_index {
+    public:
+        using point = basic_vec2<T>;
+
+        basic_main_index( const point *points, size_t count, std::pmr::memory_resource *memory = std::pmr::get_default_resource( ) );
+
+        explicit basic_main_index( const std::vector<point> &points, std::pmr::memory_resource *memory = std::pmr::get_default_resource( ) )
+            : basic_main_index( points.data( ), points.size( ), memory ) {
+        }
+
+        // Same as is_main_link( points, point, next )
+        // Inline: almost every FPL point stops at the filter, a multiply and a load
+        bool is_link( const point &p, const point &next ) const {
+            return maybe_main( p ) && maybe_main( next ) && link_of( p, next );
+        }
+
+    private:
+        // False: p is none of the main points, true: it may be one
+        bool maybe_main( const point &p ) const {
+            const auto f = filter_of( p );
+            return ( m_filter[ f / 64 ] >> ( f % 64 ) & 1 ) != 0;
+        }
+
+        // Bit of p in m_filter: Fibonacci hashing, the top bits of the product
+        size_t filter_of( const point &p ) const {
+            return static_cast< size_t >( ( key_of( p ) * 0x9e3779b97f4a7c15ull ) >> m_filter_shift );
+        }
+
+        // Bits of a coordinate for the hash, -0 == 0 so both hash as 0
+        static uint64_t coord_bits( T v ) {
+            if constexpr ( std::is_floating_point_v<T> ) {
+                v = v == T( 0 ) ? T( 0 ) : v;
+            }
+
+            if constexpr ( sizeof( T ) <= sizeof( uint32_t ) ) {
+                uint32_t ret = 0;
+                std::memcpy( &ret, &v, sizeof( v ) );
+                return ret;
+            }
+            else {
+                uint64_t ret = 0;
+                std::memcpy( &ret, &v, sizeof( v ) );
+                return ret;
+            }
+        }
+
+        // Both coordinates of a point in 64 bits, 64-bit ones folded
+        static uint64_t key_of( const point &p ) {
+            const auto bx = coord_bits( p.x );
+            const auto by = coord_bits( p.y );
+            return sizeof( T ) <= sizeof( uint32_t ) ? ( bx << 32 ) | by : bx ^ ( by * 0x9e3779b97f4a7c15ull );
+        }
+
+        // is_link past the filter
+        bool link_of( const point &p, const point &next ) const;
+
+        // Index of the first main point equal to p (as std::find), m_count if none
+        size_t first_of( const point &p ) const;
+
+        size_t slot_of( const point &p ) const;
+
+        const point *m_points;
+        size_t m_count;
+
+        // Index + 1 of a main point per slot, 0 is empty, at most half of them are used
+        std::pmr::vector<uint32_t> m_slots;
+        size_t m_mask = 0;
+
+        // A bit per hash of the main points: a point with its bit clear is none of them
+        std::pmr::vector<uint64_t> m_filter;
+        int m_filter_shift = 0;
+    };
+
+    using main_index = basic_main_index<float>;
+
+    // Compacts the count points of one main segment in run in place, as do_fpl does: drops repeats
+    // of the point kept before (prev, none for the first segment) and starts of main links,
+    // point b is always kept
+    // Returns the count of points kept
+    template <typename T>
+    size_t compact_run( const basic_main_index<T> &mains, const basic_vec2<T> *prev, basic_vec2<T> *run, size_t count );
+
+    // The same from the points x[ n ], y[ n ] (a level of fpl_tree) to out, with no copy in between
+    size_t compact_run( const main_index &mains, const vec2 *prev, const float *x, const float *y, size_t count, vec2 *out );
+
+    // Point kept right before main segment i: point b of the segment before (seam of the two)
+    inline const vec2 *seam_point( const std::vector<vec2> &points, size_t i ) {
+        return i > 0 ? &points[ 2 * i - 1 ] : nullptr;
+    }
+
+    // Moves the compacted runs fpl[ first[ i ] .. first[ i ] + count[ i ] ) of the main segments
+    // next to each other in order (first[ i ] can't be less than the sum of the counts before), cuts fpl after them
+    // ends (if any) gets the index of point b of every main segment
+    template <typename T>
+    void pack_runs( std::vector<basic_vec2<T>> &fpl, const std::vector<size_t> &first, const std::vector<size_t> &count, std::vector<size_t> *ends );
+
+    // True if every main point is in the range of the scalar of prec (|x|, |y| < fixed_range for fixed)
+    inline bool in_range( int prec, const std::vector<vec2> &points ) {
+        if ( prec != prec_fixed ) {
+            return true;
+        }
+
+        for ( const auto &p : points ) {
+            if ( !( std::fabs( p.x ) < fixed_range && std::fabs( p.y ) < fixed_range ) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // FPL of the main lines, points are pairs (a, b) of segments
+    // Duplicated points between neighbour segments are dropped
+    // Same seed and stream -> same FPL (main segment n uses the offsets tree { seed, stream, n })
+    // ends (if any) gets the index of point b of every main segment in the FPL
+    // workers (if any) make the main segments in parallel, each into its own slot, the FPL is the same
+    // prec: do_fpl_in of that scalar rounded to float for drawing (the float one uses the SIMD level kernels)
+    std::vector<vec2> do_fpl( const std::vector<vec2> &points, int r, int delta, int gen_type, float stddev, float s, uint64_t seed, uint64_t stream = 0,
+                              std::vector<size_t> *ends = nullptr, pool *workers = nullptr, int prec = prec_float );
+
+    // do_fpl with the points made and compacted in T (double or fixed32), kept in T: the depth-first engine,
+    // a point is dropped by its value in T, not by the float it rounds to
+    template <typename T>
+    std::vector<basic_vec2<T>> do_fpl_in( const std::vector<vec2> &points, int r, int delta, int gen_type, float stddev, float s, uint64_t seed,
+                                          uint64_t stream = 0, std::vector<size_t> *ends = nullptr, pool *workers = nullptr );
+
+    inline std::vector<vec2> do_fpl( const std::vector<vec2> &points, const settings &cfg, pool *workers = nullptr ) {
+        return do_fpl( points, cfg.r, cfg.delta, cfg.gen_type, cfg.stddev, cfg.s( ), cfg.seed, 0, nullptr, workers, cfg.precision );
+    }
+}
@@ -0,0 +1,71 @@
+#include "job.h"
+
+namespace fpl {
+    latest_job::latest_job( ) {
+        m_thread = std::thread( &latest_job::loop, this );
+    }
+
+    latest_job::~latest_job( ) {
+        stop( );
+    }
+
+    void latest_job::submit( job fn ) {
+        std::lock_guard<std::mutex> lock( m_mtx );
+        if ( m_stop ) {
+            return;
+        }
+
+        m_pending = std::move( fn );
+        m_cancel = true;
+        m_cv.notify_one( );
+    }
+
+    void latest_job::cancel( ) {
+        std::lock_guard<std::mutex> lock( m_mtx );
+        m_pending = nullptr;
+        m_cancel = true;
+    }
+
+    bool latest_job::busy( ) {
+        std::lock_guard<std::mutex> lock( m_mtx );
+        return m_running || m_pending;
+    }
+
+    void latest_job::stop( ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mtx );
+            m_stop = true;
+            m_pending = nullptr;
+            m_cancel = true;
+        }
+
+        m_cv.notify_one( );
+
+        if ( m_thread.joinable( ) ) {
+            m_thread.join( );
+        }
+    }
+
+    void latest_job::loop( ) {
+        std::unique_lock<std::mutex> lock( m_mtx );
+
+        for ( ;; ) {
+            m_cv.wait( lock, [ this ]( ) { return m_stop || m_pending; } );
+            if ( m_stop ) {
+                return;
+            }
+
+            // Reset under the lock, so a submit( ) right after this cancels the new job
+            auto fn = std::move( m_pending );
+            m_pending = nullptr;
+            m_cancel = false;
+            m_running = true;
+
+            lock.unlock( );
+            fn( m_cancel );
+            lock.lock( );
+
+            m_running = false;
+        }
+    }
+}
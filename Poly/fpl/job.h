@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace fpl {
+    // Background thread that runs only the newest submitted job
+    // A new submit( ) drops the pending job and cancels the running one:
+    // its cancel flag goes up and the job is expected to return at its next checkpoint
+    class latest_job {
+    public:
+        using job = std::function<void( const std::atomic<bool> &cancel )>;
+
+        latest_job( );
+        ~latest_job( );
+
+        latest_job( const latest_job & ) = delete;
+        latest_job &operator=( const latest_job & ) = delete;
+
+        void submit( job fn );
+
+        // Drops the pending job and cancels the running one
+        void cancel( );
+
+        // Running or pending job
+        bool busy( );
+
+        // Cancels everything and joins the thread, submit( ) does nothing after it
+        void stop( );
+
+    private:
+        void loop( );
+
+        std::thread m_thread;
+
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+
+        // Guarded by m_mtx
+        job m_pending;
+        bool m_running = false;
+        bool m_stop = false;
+
+        // Cancel flag of the running job
+        std::atomic<bool> m_cancel { false };
+    };
+
+    // Double buffer between a producer thread and the UI
+    // publish( ) swaps a complete value in, consume( ) swaps it out, neither blocks for long
+    template <typename T>
+    class snapshot {
+    public:
+        // value gets the previous unconsumed snapshot (or an empty T) back
+        void publish( T &value ) {
+            std::lock_guard<std::mutex> lock( m_mtx );
+            std::swap( m_ready, value );
+            m_fresh = true;
+        }
+
+        // False if nothing new was published since the last call
+        bool consume( T &value ) {
+            std::lock_guard<std::mutex> lock( m_mtx );
+            if ( !m_fresh ) {
+                return false;
+            }
+
+            std::swap( m_ready, value );
+            m_fresh = false;
+            return true;
+        }
+
+    private:
+        std::mutex m_mtx;
+        T m_ready {};
+        bool m_fresh = false;
+    };
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace rng {
+    // Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+    // Same (counter, key) -> same 4 words, no state, any order, any thread
+    inline std::array<uint32_t, 4> philox4x32( std::array<uint32_t, 4> ctr, std::array<uint32_t, 2> key ) {
+        constexpr uint32_t m0 = 0xD2511F53u, m1 = 0xCD9E8D57u;
+        constexpr uint32_t w0 = 0x9E3779B9u, w1 = 0xBB67AE85u;
+
+        for ( int round = 0; round < 10; ++round ) {
+            const auto p0 = static_cast< uint64_t >( m0 ) * ctr[ 0 ];
+            const auto p1 = static_cast< uint64_t >( m1 ) * ctr[ 2 ];
+
+            ctr = {
+                static_cast< uint32_t >( p1 >> 32 ) ^ ctr[ 1 ] ^ key[ 0 ],
+                static_cast< uint32_t >( p1 ),
+                static_cast< uint32_t >( p0 >> 32 ) ^ ctr[ 3 ] ^ key[ 1 ],
+                static_cast< uint32_t >( p0 )
+            };
+
+            key[ 0 ] += w0;
+            key[ 1 ] += w1;
+        }
+
+        return ctr;
+    }
+
+    // Key of the offsets tree of one main segment of one FPL
+    struct node_key {
+        uint64_t seed = 0;
+
+        // Realisation (0 is the FPL on the canvas), low 32 bits are used
+        uint64_t stream = 0;
+
+        // Main segment (fpl::segment_id of its a, b)
+        uint32_t segment = 0;
+    };
+
+    // [0, 1) from the top 24 bits
+    inline float to_unit( uint32_t w ) {
+        return static_cast< float >( w >> 8 ) * ( 1.f / 16777216.f );
+    }
+
+    // Words of the block holding node k of level l, a block serves 4 uniform or 2 normal nodes
+    inline std::array<uint32_t, 4> node_block( const node_key &key, int l, uint64_t block ) {
+        // Node index < 2^30 (max depth), level < 2^8
+        const auto c1 = static_cast< uint32_t >( l ) | ( static_cast< uint32_t >( block >> 32 ) << 8 );
+        return philox4x32( { static_cast< uint32_t >( block ), c1, key.segment, static_cast< uint32_t >( key.stream ) },
+                           { static_cast< uint32_t >( key.seed ), static_cast< uint32_t >( key.seed >> 32 ) } );
+    }
+
+    // U(-1, 1) offset of node k of level l
+    inline float unit_uniform( const node_key &key, int l, uint64_t k ) {
+        const auto w = node_block( key, l, k >> 2 );
+        return to_unit( w[ k & 3 ] ) * 2.f - 1.f;
+    }
+
+    // log( u ) for a normal u > 0 (Cephes logf), only + - * and bit ops,
+    // so rng::fill_normal can do the very same ops in SIMD and get the same floats
+    inline float log_unit( float u ) {
+        uint32_t bits = 0;
+        std::memcpy( &bits, &u, sizeof( bits ) );
+
+        // u = m * 2^e, m in [0.5, 1)
+        auto e = static_cast< int >( bits >> 23 ) - 126;
+        bits = ( bits & 0x007FFFFFu ) | 0x3F000000u;
+
+        float m = 0.f;
+        std::memcpy( &m, &bits, sizeof( m ) );
+
+        // x in [sqrt( 0.5 ) - 1, sqrt( 2 ) - 1), both ways are exact
+        auto x = m - 1.f;
+        if ( m < 0.707106781186547524f ) {
+            e -= 1;
+            x = x + m;
+        }
+
+        const auto z = x * x;
+        const auto fe = static_cast< float >( e );
+
+        auto y = 7.0376836292e-2f * x - 1.1514610310e-1f;
+        y = y * x + 1.1676998740e-1f;
+        y = y * x - 1.2420140846e-1f;
+        y = y * x + 1.4249322787e-1f;
+        y = y * x - 1.6668057665e-1f;
+        y = y * x + 2.0000714765e-1f;
+        y = y * x - 2.4999993993e-1f;
+        y = y * x + 3.3333331174e-1f;
+        y = y * x * z;
+
+        y = y + -2.12194440e-4f * fe;
+        y = y - 0.5f * z;
+
+        auto ret = x + y;
+        ret = ret + 0.693359375f * fe;
+        return ret;
+    }
+
+    // 2 pi / 2^24: one step of a 24 bit fraction of a turn
+    constexpr float turn_step = 6.28318530718f / 16777216.f;
+
+    // sin and cos of q / 2^24 turns (Cephes sinf/cosf), q < 2^24
+    // The quadrant comes from the integer, so the polynomials only see [-pi/4, pi/4]
+    inline void sincos_turn( uint32_t q, float &sin_out, float &cos_out ) {
+        const auto j = ( q + ( 1u << 21 ) ) >> 22;
+        const auto t = static_cast< float >( static_cast< int32_t >( q - ( j << 22 ) ) ) * turn_step;
+        const auto z = t * t;
+
+        auto sn = -1.9515295891e-4f * z + 8.3321608736e-3f;
+        sn = sn * z - 1.6666654611e-1f;
+        sn = sn * z * t + t;
+
+        auto cs = 2.443315711809948e-5f * z - 1.388731625493765e-3f;
+        cs = cs * z + 4.166664568298827e-2f;
+        cs = cs * z * z;
+        cs = cs - 0.5f * z;
+        cs = cs + 1.f;
+
+        // Angle t + j * pi / 2
+        switch ( j & 3 ) {
+            case 0: sin_out = sn; cos_out = cs; break;
+            case 1: sin_out = cs; cos_out = -sn; break;
+            case 2: sin_out = -sn; cos_out = -cs; break;
+            default: sin_out = -cs; cos_out = sn; break;
+        }
+    }
+
+    // N(0, 1) offset of node k of level l (Box-Muller, nodes 2j and 2j + 1 share a pair)
+    inline float unit_normal( const node_key &key, int l, uint64_t k ) {
+        const auto w = node_block( key, l, k >> 1 );
+
+        // u1 in (0, 1] so log( u1 ) is finite
+        const auto u1 = static_cast< float >( ( w[ 0 ] >> 8 ) + 1 ) * ( 1.f / 16777216.f );
+        const auto radius = std::sqrt( -2.f * log_unit( u1 ) );
+
+        float sn = 0.f, cs = 0.f;
+        sincos_turn( w[ 1 ] >> 8, sn, cs );
+
+        return ( k & 1 ) ? radius * sn : radius * cs;
+    }
+}
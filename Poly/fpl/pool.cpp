@@ -0,0 +1,153 @@
+#include "pool.h"
+
+namespace fpl {
+    pool::pool( unsigned threads ) {
+        if ( threads == 0 ) {
+            threads = std::thread::hardware_concurrency( );
+        }
+
+        if ( threads == 0 ) {
+            threads = 1;
+        }
+
+        // Queue 0 belongs to the thread calling run( )
+        m_queues = std::vector<queue>( threads );
+
+        m_threads.reserve( threads - 1 );
+        for ( unsigned i = 0; i + 1 < threads; ++i ) {
+            m_threads.emplace_back( &pool::worker, this, i + 1 );
+        }
+    }
+
+    pool::~pool( ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mtx );
+            m_stop = true;
+        }
+
+        m_wake.notify_all( );
+
+        for ( auto &t : m_threads ) {
+            t.join( );
+        }
+    }
+
+    void pool::run( size_t count, const std::function<void( size_t )> &task ) {
+        if ( count == 0 ) {
+            return;
+        }
+
+        // Nothing to share -> run in place
+        if ( m_threads.empty( ) || count == 1 ) {
+            for ( size_t i = 0; i < count; ++i ) {
+                task( i );
+            }
+
+            return;
+        }
+
+        std::lock_guard<std::mutex> run_lock( m_run_mtx );
+
+        // Contiguous blocks per participant, so neighbour tasks stay on one thread unless stolen
+        const size_t parts = m_queues.size( );
+        for ( size_t p = 0; p < parts; ++p ) {
+            auto &q = m_queues[ p ];
+            std::lock_guard<std::mutex> lock( q.mtx );
+
+            q.first = count * p / parts;
+            q.last = count * ( p + 1 ) / parts;
+        }
+
+        m_pending = count;
+
+        {
+            std::lock_guard<std::mutex> lock( m_mtx );
+            m_task = &task;
+            ++m_generation;
+        }
+
+        m_wake.notify_all( );
+
+        drain( 0, task );
+
+        // Workers must be out of drain( ) before task goes out of scope
+        std::unique_lock<std::mutex> lock( m_mtx );
+        m_done.wait( lock, [ this ]( ) { return m_pending == 0 && m_busy == 0; } );
+        m_task = nullptr;
+    }
+
+    pool &pool::shared( ) {
+        static pool s_pool;
+        return s_pool;
+    }
+
+    void pool::worker( unsigned id ) {
+        size_t seen = 0;
+
+        for ( ;; ) {
+            const std::function<void( size_t )> *task = nullptr;
+
+            {
+                std::unique_lock<std::mutex> lock( m_mtx );
+                m_wake.wait( lock, [ & ]( ) { return m_stop || ( m_task && m_generation != seen ); } );
+
+                if ( m_stop ) {
+                    return;
+                }
+
+                seen = m_generation;
+                task = m_task;
+                ++m_busy;
+            }
+
+            drain( id, *task );
+
+            {
+                std::lock_guard<std::mutex> lock( m_mtx );
+                --m_busy;
+            }
+
+            m_done.notify_all( );
+        }
+    }
+
+    void pool::drain( unsigned id, const std::function<void( size_t )> &task ) {
+        size_t i = 0;
+        while ( pop( id, i ) ) {
+            task( i );
+
+            // Last task of the run -> wake up the caller
+            if ( --m_pending == 0 ) {
+                std::lock_guard<std::mutex> lock( m_mtx );
+                m_done.notify_all( );
+            }
+        }
+    }
+
+    bool pool::pop( unsigned id, size_t &out ) {
+        // Own queue, newest first
+        {
+            auto &q = m_queues[ id ];
+            std::lock_guard<std::mutex> lock( q.mtx );
+
+            if ( q.first != q.last ) {
+                out = --q.last;
+                return true;
+            }
+        }
+
+        // Stealing the oldest task of the others
+        const auto parts = m_queues.size( );
+        for ( size_t n = 1; n < parts; ++n ) {
+            auto &q = m_queues[ ( id + n ) % parts ];
+            std::lock_guard<std::mutex> lock( q.mtx );
+
+            if ( q.first != q.last ) {
+                out = q.first++;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
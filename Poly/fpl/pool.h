@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fpl {
+    // Fixed set of worker threads for independent tasks
+    // Every participant (workers + the calling thread) owns a contiguous range of task ids,
+    // pops from its back and steals from the front of the others when it runs dry
+    class pool {
+    public:
+        // threads: how many threads run the tasks, the caller of run( ) included
+        // 0 -> one per hardware thread, 1 -> everything runs on the caller
+        explicit pool( unsigned threads = 0 );
+        ~pool( );
+
+        pool( const pool & ) = delete;
+        pool &operator=( const pool & ) = delete;
+
+        // Count of threads running tasks, the caller included
+        unsigned size( ) const {
+            return static_cast< unsigned >( m_queues.size( ) );
+        }
+
+        // Calls task( i ) for every i in [0, count) and blocks until all of them are done
+        // - tasks may run in any order and on any thread, they must not call run( ) again
+        // - runs from different threads take turns
+        // - no heap allocation of its own: pass std::ref( fn ) for a callable that doesn't fit in std::function
+        void run( size_t count, const std::function<void( size_t )> &task );
+
+        // Pool shared by the whole app
+        static pool &shared( );
+
+    private:
+        // Tasks [first, last) left to the participant
+        struct queue {
+            std::mutex mtx;
+            size_t first = 0;
+            size_t last = 0;
+        };
+
+        void worker( unsigned id );
+
+        // Runs tasks of the current run( ) until every queue is empty
+        void drain( unsigned id, const std::function<void( size_t )> &task );
+
+        // Next task for the participant id: own back first, then the front of others
+        bool pop( unsigned id, size_t &out );
+
+        std::vector<std::thread> m_threads;
+        std::vector<queue> m_queues;
+
+        // One run( ) at a time
+        std::mutex m_run_mtx;
+
+        std::mutex m_mtx;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+
+        // Guarded by m_mtx
+        const std::function<void( size_t )> *m_task = nullptr;
+        size_t m_generation = 0;
+        unsigned m_busy = 0;
+        bool m_stop = false;
+
+        std::atomic<size_t> m_pending { 0 };
+    };
+
+    // fn( i ) for every i in [0, count), block of them per task of workers (all on the caller if there are none)
+    template <typename Fn>
+    void parallel_for( pool *workers, size_t count, size_t block, Fn &&fn ) {
+        block = block > 0 ? block : 1;
+
+        if ( !workers || workers->size( ) == 1 || count <= block ) {
+            for ( size_t i = 0; i < count; ++i ) {
+                fn( i );
+            }
+
+            return;
+        }
+
+        auto task = [ & ]( size_t task ) {
+            const auto end = ( task + 1 ) * block < count ? ( task + 1 ) * block : count;
+            for ( size_t i = task * block; i < end; ++i ) {
+                fn( i );
+            }
+        };
+
+        workers->run( ( count + block - 1 ) / block, std::ref( task ) );
+    }
+}
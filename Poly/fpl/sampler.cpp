@@ -0,0 +1,342 @@
+#include "sampler.h"
+
+// FPL_NO_SIMD forces the scalar path
+// Philox needs 32 bit integer lanes, so 256 bit lanes need AVX2 (AVX alone has no integer ops)
+#if defined( FPL_NO_SIMD )
+#elif defined( __AVX2__ )
+#include <immintrin.h>
+#define FPL_AVX2_LANES
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define FPL_SSE_LANES
+#endif
+
+namespace rng {
+    namespace {
+        void uniform_scalar( const node_key &key, int l, uint64_t first, size_t count, float s, float *out ) {
+            for ( size_t i = 0; i < count; ++i ) {
+                out[ i ] = s * unit_uniform( key, l, first + i );
+            }
+        }
+
+        void normal_scalar( const node_key &key, int l, uint64_t first, size_t count, float stddev, float *out ) {
+            for ( size_t i = 0; i < count; ++i ) {
+                out[ i ] = stddev * unit_normal( key, l, first + i );
+            }
+        }
+
+#if defined( FPL_AVX2_LANES ) || defined( FPL_SSE_LANES )
+#if defined( FPL_AVX2_LANES )
+        // 8 blocks at a time
+        struct lanes {
+            using vi = __m256i;
+            using vf = __m256;
+            static constexpr size_t width = 8;
+
+            static vi set( uint32_t v ) { return _mm256_set1_epi32( static_cast< int >( v ) ); }
+            static vf setf( float v ) { return _mm256_set1_ps( v ); }
+            static vi iota( ) { return _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ); }
+
+            static vi add( vi a, vi b ) { return _mm256_add_epi32( a, b ); }
+            static vi sub( vi a, vi b ) { return _mm256_sub_epi32( a, b ); }
+            static vi bxor( vi a, vi b ) { return _mm256_xor_si256( a, b ); }
+            static vi band( vi a, vi b ) { return _mm256_and_si256( a, b ); }
+            static vi bor( vi a, vi b ) { return _mm256_or_si256( a, b ); }
+            static vi eq( vi a, vi b ) { return _mm256_cmpeq_epi32( a, b ); }
+            template <int n> static vi shr( vi a ) { return _mm256_srli_epi32( a, n ); }
+            template <int n> static vi shl( vi a ) { return _mm256_slli_epi32( a, n ); }
+
+            // 32 x 32 -> 64 of every lane, split into the high and the low words
+            static void mul_hilo( vi a, vi m, vi &hi, vi &lo ) {
+                const auto p02 = _mm256_mul_epu32( a, m );
+                const auto p13 = _mm256_mul_epu32( _mm256_srli_epi64( a, 32 ), m );
+
+                lo = _mm256_unpacklo_epi32( _mm256_shuffle_epi32( p02, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm256_shuffle_epi32( p13, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+                hi = _mm256_unpacklo_epi32( _mm256_shuffle_epi32( p02, _MM_SHUFFLE( 0, 0, 3, 1 ) ), _mm256_shuffle_epi32( p13, _MM_SHUFFLE( 0, 0, 3, 1 ) ) );
+            }
+
+            static vf to_float( vi a ) { return _mm256_cvtepi32_ps( a ); }
+            static vf as_float( vi a ) { return _mm256_castsi256_ps( a ); }
+            static vi as_int( vf a ) { return _mm256_castps_si256( a ); }
+
+            static vf add( vf a, vf b ) { return _mm256_add_ps( a, b ); }
+            static vf sub( vf a, vf b ) { return _mm256_sub_ps( a, b ); }
+            static vf mul( vf a, vf b ) { return _mm256_mul_ps( a, b ); }
+            static vf sqrt( vf a ) { return _mm256_sqrt_ps( a ); }
+            static vf band( vf a, vf b ) { return _mm256_and_ps( a, b ); }
+            static vf less( vf a, vf b ) { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+            static vf select( vf mask, vf a, vf b ) { return _mm256_blendv_ps( b, a, mask ); }
+
+            // a0 b0 a1 b1 ...
+            static void store_pairs( float *out, vf a, vf b ) {
+                const auto lo = _mm256_unpacklo_ps( a, b );
+                const auto hi = _mm256_unpackhi_ps( a, b );
+
+                _mm256_storeu_ps( out, _mm256_permute2f128_ps( lo, hi, 0x20 ) );
+                _mm256_storeu_ps( out + 8, _mm256_permute2f128_ps( lo, hi, 0x31 ) );
+            }
+
+            // a0 b0 c0 d0 a1 b1 c1 d1 ...
+            static void store_quads( float *out, vf a, vf b, vf c, vf d ) {
+                const auto t0 = _mm256_unpacklo_ps( a, b );
+                const auto t1 = _mm256_unpacklo_ps( c, d );
+                const auto t2 = _mm256_unpackhi_ps( a, b );
+                const auto t3 = _mm256_unpackhi_ps( c, d );
+
+                // Blocks 0 | 4, 1 | 5, 2 | 6, 3 | 7
+                const auto r0 = _mm256_shuffle_ps( t0, t1, 0x44 );
+                const auto r1 = _mm256_shuffle_ps( t0, t1, 0xEE );
+                const auto r2 = _mm256_shuffle_ps( t2, t3, 0x44 );
+                const auto r3 = _mm256_shuffle_ps( t2, t3, 0xEE );
+
+                _mm256_storeu_ps( out, _mm256_permute2f128_ps( r0, r1, 0x20 ) );
+                _mm256_storeu_ps( out + 8, _mm256_permute2f128_ps( r2, r3, 0x20 ) );
+                _mm256_storeu_ps( out + 16, _mm256_permute2f128_ps( r0, r1, 0x31 ) );
+                _mm256_storeu_ps( out + 24, _mm256_permute2f128_ps( r2, r3, 0x31 ) );
+            }
+        };
+#else
+        // 4 blocks at a time
+        struct lanes {
+            using vi = __m128i;
+            using vf = __m128;
+            static constexpr size_t width = 4;
+
+            static vi set( uint32_t v ) { return _mm_set1_epi32( static_cast< int >( v ) ); }
+            static vf setf( float v ) { return _mm_set1_ps( v ); }
+            static vi iota( ) { return _mm_setr_epi32( 0, 1, 2, 3 ); }
+
+            static vi add( vi a, vi b ) { return _mm_add_epi32( a, b ); }
+            static vi sub( vi a, vi b ) { return _mm_sub_epi32( a, b ); }
+            static vi bxor( vi a, vi b ) { return _mm_xor_si128( a, b ); }
+            static vi band( vi a, vi b ) { return _mm_and_si128( a, b ); }
+            static vi bor( vi a, vi b ) { return _mm_or_si128( a, b ); }
+            static vi eq( vi a, vi b ) { return _mm_cmpeq_epi32( a, b ); }
+            template <int n> static vi shr( vi a ) { return _mm_srli_epi32( a, n ); }
+            template <int n> static vi shl( vi a ) { return _mm_slli_epi32( a, n ); }
+
+            // 32 x 32 -> 64 of every lane, split into the high and the low words (SSE2 only has the even lanes)
+            static void mul_hilo( vi a, vi m, vi &hi, vi &lo ) {
+                const auto p02 = _mm_mul_epu32( a, m );
+                const auto p13 = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), m );
+
+                lo = _mm_unpacklo_epi32( _mm_shuffle_epi32( p02, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( p13, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+                hi = _mm_unpacklo_epi32( _mm_shuffle_epi32( p02, _MM_SHUFFLE( 0, 0, 3, 1 ) ), _mm_shuffle_epi32( p13, _MM_SHUFFLE( 0, 0, 3, 1 ) ) );
+            }
+
+            static vf to_float( vi a ) { return _mm_cvtepi32_ps( a ); }
+            static vf as_float( vi a ) { return _mm_castsi128_ps( a ); }
+            static vi as_int( vf a ) { return _mm_castps_si128( a ); }
+
+            static vf add( vf a, vf b ) { return _mm_add_ps( a, b ); }
+            static vf sub( vf a, vf b ) { return _mm_sub_ps( a, b ); }
+            static vf mul( vf a, vf b ) { return _mm_mul_ps( a, b ); }
+            static vf sqrt( vf a ) { return _mm_sqrt_ps( a ); }
+            static vf band( vf a, vf b ) { return _mm_and_ps( a, b ); }
+            static vf less( vf a, vf b ) { return _mm_cmplt_ps( a, b ); }
+            static vf select( vf mask, vf a, vf b ) { return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) ); }
+
+            // a0 b0 a1 b1 ...
+            static void store_pairs( float *out, vf a, vf b ) {
+                _mm_storeu_ps( out, _mm_unpacklo_ps( a, b ) );
+                _mm_storeu_ps( out + 4, _mm_unpackhi_ps( a, b ) );
+            }
+
+            // a0 b0 c0 d0 a1 b1 c1 d1 ...
+            static void store_quads( float *out, vf a, vf b, vf c, vf d ) {
+                const auto t0 = _mm_unpacklo_ps( a, b );
+                const auto t1 = _mm_unpacklo_ps( c, d );
+                const auto t2 = _mm_unpackhi_ps( a, b );
+                const auto t3 = _mm_unpackhi_ps( c, d );
+
+                _mm_storeu_ps( out, _mm_movelh_ps( t0, t1 ) );
+                _mm_storeu_ps( out + 4, _mm_movehl_ps( t1, t0 ) );
+                _mm_storeu_ps( out + 8, _mm_movelh_ps( t2, t3 ) );
+                _mm_storeu_ps( out + 12, _mm_movehl_ps( t3, t2 ) );
+            }
+        };
+#endif
+
+        using vi = lanes::vi;
+        using vf = lanes::vf;
+
+        // Philox4x32-10 of blocks block .. block + width - 1 (the same ops as rng::philox4x32)
+        // The blocks must not cross a multiple of 2^32
+        void philox_lanes( const node_key &key, int l, uint64_t block, vi w[ 4 ] ) {
+            vi c0 = lanes::add( lanes::set( static_cast< uint32_t >( block ) ), lanes::iota( ) );
+            vi c1 = lanes::set( static_cast< uint32_t >( l ) | ( static_cast< uint32_t >( block >> 32 ) << 8 ) );
+            vi c2 = lanes::set( key.segment );
+            vi c3 = lanes::set( static_cast< uint32_t >( key.stream ) );
+
+            const auto m0 = lanes::set( 0xD2511F53u );
+            const auto m1 = lanes::set( 0xCD9E8D57u );
+
+            auto k0 = static_cast< uint32_t >( key.seed );
+            auto k1 = static_cast< uint32_t >( key.seed >> 32 );
+
+            for ( int round = 0; round < 10; ++round ) {
+                vi hi0, lo0, hi1, lo1;
+                lanes::mul_hilo( c0, m0, hi0, lo0 );
+                lanes::mul_hilo( c2, m1, hi1, lo1 );
+
+                c0 = lanes::bxor( lanes::bxor( hi1, c1 ), lanes::set( k0 ) );
+                c1 = lo1;
+                c2 = lanes::bxor( lanes::bxor( hi0, c3 ), lanes::set( k1 ) );
+                c3 = lo0;
+
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+
+            w[ 0 ] = c0;
+            w[ 1 ] = c1;
+            w[ 2 ] = c2;
+            w[ 3 ] = c3;
+        }
+
+        // True if blocks block .. block + width - 1 share their high word
+        bool same_high( uint64_t block ) {
+            return ( block >> 32 ) == ( ( block + lanes::width - 1 ) >> 32 );
+        }
+
+        // s * ( to_unit( w ) * 2 - 1 )
+        vf uniform_lanes( vi w, vf s ) {
+            const auto u = lanes::mul( lanes::to_float( lanes::shr<8>( w ) ), lanes::setf( 1.f / 16777216.f ) );
+            return lanes::mul( s, lanes::sub( lanes::mul( u, lanes::setf( 2.f ) ), lanes::setf( 1.f ) ) );
+        }
+
+        // rng::log_unit
+        vf log_lanes( vf u ) {
+            const auto bits = lanes::as_int( u );
+
+            auto e = lanes::sub( lanes::shr<23>( bits ), lanes::set( 126u ) );
+            const auto m = lanes::as_float( lanes::bor( lanes::band( bits, lanes::set( 0x007FFFFFu ) ), lanes::set( 0x3F000000u ) ) );
+
+            // Mask lanes are -1 as integers
+            const auto mask = lanes::less( m, lanes::setf( 0.707106781186547524f ) );
+            e = lanes::add( e, lanes::as_int( mask ) );
+            const auto x = lanes::add( lanes::sub( m, lanes::setf( 1.f ) ), lanes::band( mask, m ) );
+
+            const auto z = lanes::mul( x, x );
+            const auto fe = lanes::to_float( e );
+
+            auto y = lanes::sub( lanes::mul( lanes::setf( 7.0376836292e-2f ), x ), lanes::setf( 1.1514610310e-1f ) );
+            y = lanes::add( lanes::mul( y, x ), lanes::setf( 1.1676998740e-1f ) );
+            y = lanes::sub( lanes::mul( y, x ), lanes::setf( 1.2420140846e-1f ) );
+            y = lanes::add( lanes::mul( y, x ), lanes::setf( 1.4249322787e-1f ) );
+            y = lanes::sub( lanes::mul( y, x ), lanes::setf( 1.6668057665e-1f ) );
+            y = lanes::add( lanes::mul( y, x ), lanes::setf( 2.0000714765e-1f ) );
+            y = lanes::sub( lanes::mul( y, x ), lanes::setf( 2.4999993993e-1f ) );
+            y = lanes::add( lanes::mul( y, x ), lanes::setf( 3.3333331174e-1f ) );
+            y = lanes::mul( lanes::mul( y, x ), z );
+
+            y = lanes::add( y, lanes::mul( lanes::setf( -2.12194440e-4f ), fe ) );
+            y = lanes::sub( y, lanes::mul( lanes::setf( 0.5f ), z ) );
+
+            const auto ret = lanes::add( x, y );
+            return lanes::add( ret, lanes::mul( lanes::setf( 0.693359375f ), fe ) );
+        }
+
+        // rng::sincos_turn
+        void sincos_lanes( vi q, vf &sin_out, vf &cos_out ) {
+            const auto j = lanes::shr<22>( lanes::add( q, lanes::set( 1u << 21 ) ) );
+            const auto t = lanes::mul( lanes::to_float( lanes::sub( q, lanes::shl<22>( j ) ) ), lanes::setf( turn_step ) );
+            const auto z = lanes::mul( t, t );
+
+            auto sn = lanes::add( lanes::mul( lanes::setf( -1.9515295891e-4f ), z ), lanes::setf( 8.3321608736e-3f ) );
+            sn = lanes::sub( lanes::mul( sn, z ), lanes::setf( 1.6666654611e-1f ) );
+            sn = lanes::add( lanes::mul( lanes::mul( sn, z ), t ), t );
+
+            auto cs = lanes::sub( lanes::mul( lanes::setf( 2.443315711809948e-5f ), z ), lanes::setf( 1.388731625493765e-3f ) );
+            cs = lanes::add( lanes::mul( cs, z ), lanes::setf( 4.166664568298827e-2f ) );
+            cs = lanes::mul( lanes::mul( cs, z ), z );
+            cs = lanes::sub( cs, lanes::mul( lanes::setf( 0.5f ), z ) );
+            cs = lanes::add( cs, lanes::setf( 1.f ) );
+
+            // Odd quadrants swap sin and cos, the signs come from bit 1 of j (sin) and of j + 1 (cos)
+            const auto one = lanes::set( 1u );
+            const auto two = lanes::set( 2u );
+            const auto swap = lanes::as_float( lanes::eq( lanes::band( j, one ), one ) );
+            const auto neg_sin = lanes::shl<30>( lanes::band( j, two ) );
+            const auto neg_cos = lanes::shl<30>( lanes::band( lanes::add( j, one ), two ) );
+
+            sin_out = lanes::as_float( lanes::bxor( lanes::as_int( lanes::select( swap, cs, sn ) ), neg_sin ) );
+            cos_out = lanes::as_float( lanes::bxor( lanes::as_int( lanes::select( swap, sn, cs ) ), neg_cos ) );
+        }
+#endif
+    }
+
+    void fill_uniform( const node_key &key, int l, uint64_t first, size_t count, float s, float *out ) {
+        size_t i = 0;
+
+#if defined( FPL_AVX2_LANES ) || defined( FPL_SSE_LANES )
+        // Up to the first node of a block
+        const auto head = static_cast< size_t >( ( 4 - ( first & 3 ) ) & 3 );
+        if ( head >= count ) {
+            uniform_scalar( key, l, first, count, s, out );
+            return;
+        }
+
+        uniform_scalar( key, l, first, head, s, out );
+        i = head;
+
+        // A block is 4 nodes
+        const auto vs = lanes::setf( s );
+        for ( ; i + 4 * lanes::width <= count; i += 4 * lanes::width ) {
+            const auto block = ( first + i ) >> 2;
+            if ( !same_high( block ) ) {
+                uniform_scalar( key, l, first + i, 4 * lanes::width, s, out + i );
+                continue;
+            }
+
+            vi w[ 4 ];
+            philox_lanes( key, l, block, w );
+            lanes::store_quads( out + i, uniform_lanes( w[ 0 ], vs ), uniform_lanes( w[ 1 ], vs ), uniform_lanes( w[ 2 ], vs ), uniform_lanes( w[ 3 ], vs ) );
+        }
+#endif
+
+        // Tail (or everything without SIMD)
+        uniform_scalar( key, l, first + i, count - i, s, out + i );
+    }
+
+    void fill_normal( const node_key &key, int l, uint64_t first, size_t count, float stddev, float *out ) {
+        size_t i = 0;
+
+#if defined( FPL_AVX2_LANES ) || defined( FPL_SSE_LANES )
+        // Up to the first node of a block
+        const auto head = static_cast< size_t >( first & 1 );
+        if ( head >= count ) {
+            normal_scalar( key, l, first, count, stddev, out );
+            return;
+        }
+
+        normal_scalar( key, l, first, head, stddev, out );
+        i = head;
+
+        // A block is 2 nodes: radius * cos and radius * sin
+        const auto vs = lanes::setf( stddev );
+        for ( ; i + 2 * lanes::width <= count; i += 2 * lanes::width ) {
+            const auto block = ( first + i ) >> 1;
+            if ( !same_high( block ) ) {
+                normal_scalar( key, l, first + i, 2 * lanes::width, stddev, out + i );
+                continue;
+            }
+
+            vi w[ 4 ];
+            philox_lanes( key, l, block, w );
+
+            // u1 in (0, 1]
+            const auto u1 = lanes::mul( lanes::to_float( lanes::add( lanes::shr<8>( w[ 0 ] ), lanes::set( 1u ) ) ), lanes::setf( 1.f / 16777216.f ) );
+            const auto radius = lanes::sqrt( lanes::mul( lanes::setf( -2.f ), log_lanes( u1 ) ) );
+
+            vf sn, cs;
+            sincos_lanes( lanes::shr<8>( w[ 1 ] ), sn, cs );
+
+            lanes::store_pairs( out + i, lanes::mul( vs, lanes::mul( radius, cs ) ), lanes::mul( vs, lanes::mul( radius, sn ) ) );
+        }
+#endif
+
+        // Tail (or everything without SIMD)
+        normal_scalar( key, l, first + i, count - i, stddev, out + i );
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "philox.h"
+
+namespace rng {
+    // Offsets of nodes first .. first + count - 1 of level l in one go:
+    // out[ i ] = s * unit_uniform( key, l, first + i )
+    // SSE2/AVX2 when the build has them, scalar otherwise, all give the same floats
+    void fill_uniform( const node_key &key, int l, uint64_t first, size_t count, float s, float *out );
+
+    // out[ i ] = stddev * unit_normal( key, l, first + i ), SIMD Box-Muller
+    void fill_normal( const node_key &key, int l, uint64_t first, size_t count, float stddev, float *out );
+}
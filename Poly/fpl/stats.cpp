@@ -0,0 +1,736 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+
+#include "../types/vec2x.h"
+#include "arena.h"
+#include "bfs.h"
+#include "engine.h"
+#include "unrolled.h"
+
+namespace fpl {
+    namespace {
+        constexpr size_t lanes = stat_lanes;
+
+        // Unit normal of ab and its middle point: dev = |n . ( p - c )|
+        void line_frame( const vec2 &a, const vec2 &b, float &nx, float &ny, vec2 &c ) {
+            const auto vec_v = b - a;
+            const auto v_len = vec_v.length( );
+
+            nx = v_len > 0.f ? -vec_v.y / v_len : 0.f;
+            ny = v_len > 0.f ? vec_v.x / v_len : 0.f;
+            c = ( a + b ) / 2;
+        }
+
+        float dev_of( float nx, float ny, const vec2 &c, const vec2 &p ) {
+            return std::fabs( nx * ( p.x - c.x ) + ny * ( p.y - c.y ) );
+        }
+
+        float link_of( const vec2 &p, const vec2 &q ) {
+            const auto dx = q.x - p.x;
+            const auto dy = q.y - p.y;
+            return std::sqrt( dx * dx + dy * dy );
+        }
+
+        // Sums of the pieces of all main segments, in their order
+        struct stat_total {
+            line_sums sums;
+            float chord = 0.f;
+
+            void add( const line_sums &piece, const vec2 &a, const vec2 &b ) {
+                sums.max_dev = piece.max_dev > sums.max_dev ? piece.max_dev : sums.max_dev;
+                sums.sum_dev += piece.sum_dev;
+                sums.count += piece.count;
+                sums.length += piece.length;
+
+                chord += ( b - a ).length( );
+            }
+
+            stat result( ) const {
+                if ( sums.count == 0 || chord <= 0.f ) {
+                    return std::make_tuple( 0.f, 0.f, 0.f );
+                }
+
+                const auto mean_dev = sums.sum_dev / sums.count;
+                const auto elong_fact = sums.length / chord;
+
+                return std::make_tuple( sums.max_dev, mean_dev, elong_fact );
+            }
+        };
+
+        // stat_total of an FPL made in double or fixed: every point and link in double, one at a time,
+        // in the order of line_acc
+        struct wide_total {
+            double max_dev = 0.0;
+            double sum_dev = 0.0;
+            double length = 0.0;
+            double chord = 0.0;
+            size_t count = 0;
+
+            // Main segment ab the next points deviate from
+            template <typename T>
+            void begin( const basic_vec2<T> &a, const basic_vec2<T> &b, bool with_first ) {
+                const auto ax = static_cast< double >( a.x ), ay = static_cast< double >( a.y );
+                const auto vx = static_cast< double >( b.x ) - ax, vy = static_cast< double >( b.y ) - ay;
+                const auto v_len = std::sqrt( vx * vx + vy * vy );
+
+                m_nx = v_len > 0.0 ? -vy / v_len : 0.0;
+                m_ny = v_len > 0.0 ? vx / v_len : 0.0;
+                m_cx = ax + vx / 2;
+                m_cy = ay + vy / 2;
+                m_with_first = with_first;
+                m_first = true;
+
+                chord += v_len;
+            }
+
+            template <typename T>
+            void push( const basic_vec2<T> &p ) {
+                const auto x = static_cast< double >( p.x ), y = static_cast< double >( p.y );
+
+                if ( !m_first || m_with_first ) {
+                    const auto dev = std::fabs( m_nx * ( x - m_cx ) + m_ny * ( y - m_cy ) );
+                    max_dev = dev > max_dev ? dev : max_dev;
+                    sum_dev += dev;
+                    ++count;
+                }
+
+                if ( !m_first ) {
+                    length += std::sqrt( ( x - m_lx ) * ( x - m_lx ) + ( y - m_ly ) * ( y - m_ly ) );
+                }
+
+                m_lx = x;
+                m_ly = y;
+                m_first = false;
+            }
+
+            stat result( ) const {
+                if ( count == 0 || chord <= 0.0 ) {
+                    return std::make_tuple( 0.f, 0.f, 0.f );
+                }
+
+                return std::make_tuple( static_cast< float >( max_dev ), static_cast< float >( sum_dev / count ), static_cast< float >( length / chord ) );
+            }
+
+        private:
+            double m_nx = 0.0, m_ny = 0.0, m_cx = 0.0, m_cy = 0.0;
+            double m_lx = 0.0, m_ly = 0.0;
+            bool m_with_first = true;
+            bool m_first = true;
+        };
+
+        // Offsets of the subtree of node k0 of level l0 of a segment, as the nodes of a tree of its own
+        template <typename Rf>
+        struct subtree_rf {
+            const Rf &rf;
+            int l0;
+            uint64_t k0;
+
+            float operator()( int l, uint64_t k ) const {
+                return rf( l0 + l, ( k0 << l ) + k );
+            }
+
+            void operator()( int l, uint64_t first, size_t count, float *out ) const {
+                rf( l0 + l, ( k0 << l ) + first, count, out );
+            }
+        };
+
+        // Scaled offsets of a unit_tree segment, the same floats as segment_rf of the same key and scale
+        struct tree_rf {
+            const float *unit;
+            float scale;
+
+            float operator()( int l, uint64_t k ) const {
+                return scale * unit[ ( size_t( 1 ) << l ) - 1 + k ];
+            }
+
+            void operator()( int l, uint64_t first, size_t count, float *out ) const {
+                const auto *src = unit + ( size_t( 1 ) << l ) - 1 + first;
+                for ( size_t j = 0; j < count; ++j ) {
+                    out[ j ] = scale * src[ j ];
+                }
+            }
+        };
+
+        // Depth of the tiles of stream_stat: deeper trees are walked depth-first down to the tiles,
+        // the tiles are made level by level (fixed 2^tile_depth + 1 points)
+        constexpr int tile_depth = 10;
+
+        float lane_sum( const float *lane ) {
+            auto ret = lane[ 0 ];
+            for ( size_t j = 1; j < lanes; ++j ) {
+                ret += lane[ j ];
+            }
+
+            return ret;
+        }
+
+        // Points p[ 0 .. 8 * blocks ), point 8k + j and the link into it from the point before it go to lane j
+        // p[ -1 ] must exist. The lanes go on from the sums already in lane_dev, lane_len
+        void lane_blocks( const vec2 *p, size_t blocks, float nx, float ny, const vec2 &c, float *lane_dev, float *lane_len, float &max_dev ) {
+            using lane = f32xn<lanes>;
+            using points = vec2xn<lanes>;
+
+            const auto n = points::set( vec2( nx, ny ) );
+            const auto vc = points::set( c );
+
+            auto sum_dev = lane::load( lane_dev ), sum_len = lane::load( lane_len ), vmax = lane::set( max_dev );
+
+            for ( size_t k = 0; k < blocks; ++k, p += lanes ) {
+                const auto q = points::load( p );
+                const auto prev = points::load( p - 1 );
+
+                // The same ops as dev_of and link_of (no FMA)
+                const auto d = abs( n.dot( q - vc ) );
+
+                sum_dev = sum_dev + d;
+                sum_len = sum_len + ( q - prev ).length( );
+                vmax = max( vmax, d );
+            }
+
+            sum_dev.store( lane_dev );
+            sum_len.store( lane_len );
+
+            float lane_max[ lanes ];
+            vmax.store( lane_max );
+            for ( const auto m : lane_max ) {
+                max_dev = m > max_dev ? m : max_dev;
+            }
+        }
+    }
+
+    line_sums line_pass( const vec2 *points, size_t count, const vec2 &a, const vec2 &b, bool with_first ) {
+        line_acc acc( a, b, with_first );
+        acc.push( points, count );
+        return acc.sums( );
+    }
+
+    stat do_stat( const std::vector<vec2> &src_points, const std::vector<vec2> &fpl_points, const std::vector<size_t> &ends ) {
+        const auto segments = src_points.size( ) / 2;
+
+        // Check if we have any FPL's
+        if ( segments == 0 || fpl_points.empty( ) || ends.size( ) != segments ) {
+            return std::make_tuple( 0.f, 0.f, 0.f );
+        }
+
+        stat_total total;
+        size_t first = 0;
+
+        for ( size_t i = 0; i < segments; ++i ) {
+            const auto &vec_a = src_points[ 2 * i ];
+            const auto &vec_b = src_points[ 2 * i + 1 ];
+            const auto last = ends[ i ];
+
+            if ( last >= fpl_points.size( ) || last + 1 < first ) {
+                return std::make_tuple( 0.f, 0.f, 0.f );
+            }
+
+            // A segment going on from the previous one starts at its point b (counted there already)
+            const bool shared = i > 0 && fpl_points[ first - 1 ] == vec_a;
+            const auto begin = shared ? first - 1 : first;
+
+            total.add( line_pass( fpl_points.data( ) + begin, last + 1 - begin, vec_a, vec_b, !shared ), vec_a, vec_b );
+            first = last + 1;
+        }
+
+        return total.result( );
+    }
+
+    template <typename T>
+    stat do_stat_in( const std::vector<vec2> &src_points, const std::vector<basic_vec2<T>> &fpl_points, const std::vector<size_t> &ends ) {
+        const auto segments = src_points.size( ) / 2;
+
+        if ( segments == 0 || fpl_points.empty( ) || ends.size( ) != segments ) {
+            return std::make_tuple( 0.f, 0.f, 0.f );
+        }
+
+        wide_total total;
+        size_t first = 0;
+
+        for ( size_t i = 0; i < segments; ++i ) {
+            const basic_vec2<T> vec_a( src_points[ 2 * i ] );
+            const basic_vec2<T> vec_b( src_points[ 2 * i + 1 ] );
+            const auto last = ends[ i ];
+
+            if ( last >= fpl_points.size( ) || last + 1 < first ) {
+                return std::make_tuple( 0.f, 0.f, 0.f );
+            }
+
+            // As in do_stat
+            const bool shared = i > 0 && fpl_points[ first - 1 ] == vec_a;
+
+            total.begin( vec_a, vec_b, !shared );
+            for ( auto n = shared ? first - 1 : first; n <= last; ++n ) {
+                total.push( fpl_points[ n ] );
+            }
+
+            first = last + 1;
+        }
+
+        return total.result( );
+    }
+
+    template stat do_stat_in( const std::vector<vec2> &, const std::vector<vec2d> &, const std::vector<size_t> & );
+    template stat do_stat_in( const std::vector<vec2> &, const std::vector<vec2q> &, const std::vector<size_t> & );
+
+    line_acc::line_acc( const vec2 &a, const vec2 &b, bool with_first ) : m_with_first( with_first ) {
+        line_frame( a, b, m_nx, m_ny, m_c );
+    }
+
+    void line_acc::push( const vec2 &p ) {
+        // Point i >= 1 and the link into it go to lane ( i - 1 ) % lanes
+        if ( m_count == 0 ) {
+            if ( m_with_first ) {
+                m_dev0 = dev_of( m_nx, m_ny, m_c, p );
+                m_max = m_dev0;
+            }
+        }
+        else {
+            const auto lane = ( m_count - 1 ) % lanes;
+            const auto d = dev_of( m_nx, m_ny, m_c, p );
+
+            m_lane_dev[ lane ] += d;
+            m_lane_len[ lane ] += link_of( m_last, p );
+            m_max = d > m_max ? d : m_max;
+        }
+
+        m_last = p;
+        ++m_count;
+    }
+
+    void line_acc::push( const vec2 *p, size_t count ) {
+        size_t t = 0;
+
+        // One by one until the next point goes to lane 0 and the point before it is in p
+        while ( t < count && ( t == 0 || ( m_count - 1 ) % lanes != 0 ) ) {
+            push( p[ t++ ] );
+        }
+
+        const auto blocks = ( count - t ) / lanes;
+        if ( blocks > 0 ) {
+            lane_blocks( p + t, blocks, m_nx, m_ny, m_c, m_lane_dev, m_lane_len, m_max );
+
+            t += blocks * lanes;
+            m_count += blocks * lanes;
+            m_last = p[ t - 1 ];
+        }
+
+        // Tail
+        while ( t < count ) {
+            push( p[ t++ ] );
+        }
+    }
+
+    line_sums line_acc::sums( ) const {
+        line_sums ret;
+        if ( m_count == 0 ) {
+            return ret;
+        }
+
+        ret.max_dev = m_max;
+        ret.sum_dev = m_dev0 + lane_sum( m_lane_dev );
+        ret.count = ( m_with_first ? 1 : 0 ) + m_count - 1;
+        ret.length = lane_sum( m_lane_len );
+
+        return ret;
+    }
+
+    namespace {
+        // stream_segments made, compacted and summed as do_stat_in( points, do_fpl_in<T>( ... ), ends ), r in range
+        template <typename T, typename MakeRf>
+        stat stream_segments_in( const std::vector<vec2> &points, int r, int delta, MakeRf &&make_rf ) {
+            using point = basic_vec2<T>;
+            const auto segments = points.size( ) / 2;
+
+            // The main points in T and their slots in the thread's arena, given back at the end of the realisation
+            const arena_scope scope;
+            const std::pmr::vector<point> mains_t( points.begin( ), points.end( ), scope.resource( ) );
+            const basic_main_index<T> mains( mains_t.data( ), mains_t.size( ), scope.resource( ) );
+
+            wide_total total;
+
+            // Last point do_fpl_in would keep
+            bool has_kept = false;
+            point kept;
+
+            for ( size_t i = 0; i < segments; ++i ) {
+                const auto &vec_a = mains_t[ 2 * i ];
+                const auto &vec_b = mains_t[ 2 * i + 1 ];
+
+                const bool shared = has_kept && kept == vec_a;
+                total.begin( vec_a, vec_b, !shared );
+
+                auto keep = [ & ]( const point &p ) {
+                    kept = p;
+                    has_kept = true;
+                    total.push( p );
+                };
+
+                if ( shared ) {
+                    keep( kept );
+                }
+
+                // The compaction of stream_segments
+                bool has_pending = false;
+                point pending;
+
+                generate_each( vec_a, vec_b, r, delta, make_rf( i ), [ & ]( const point &p ) {
+                    if ( has_pending && !( has_kept && kept == pending ) && !mains.is_link( pending, p ) ) {
+                        keep( pending );
+                    }
+
+                    pending = p;
+                    has_pending = true;
+                } );
+
+                keep( pending );
+            }
+
+            return total.result( );
+        }
+
+        // stream_stat with the offsets of main segment i from make_rf( i ), made in the scalar of prec
+        template <typename MakeRf>
+        stat stream_segments( const std::vector<vec2> &points, int r, int delta, int prec, MakeRf &&make_rf ) {
+            const auto segments = points.size( ) / 2;
+            if ( segments == 0 ) {
+                return std::make_tuple( 0.f, 0.f, 0.f );
+            }
+
+            if ( r < 0 ) {
+                r = 0;
+            }
+            else if ( r > max_depth ) {
+                r = max_depth;
+            }
+
+            if ( prec == prec_double ) {
+                return stream_segments_in<double>( points, r, delta, make_rf );
+            }
+            else if ( prec == prec_fixed ) {
+                return stream_segments_in<fixed32>( points, r, delta, make_rf );
+            }
+
+            // Fixed scratch of the tiles and of the kept points on their way to the sums, kept between calls
+            thread_local bfs_buffers t_bfs;
+            thread_local std::vector<vec2> t_tile( capacity( tile_depth ) );
+            thread_local std::vector<vec2> t_kept( capacity( tile_depth ) );
+
+            // Slots of the main points in the thread's arena, given back at the end of the realisation
+            const arena_scope scope;
+
+            stat_total total;
+            const main_index mains( points, scope.resource( ) );
+
+            // Last point do_fpl would keep
+            bool has_kept = false;
+            vec2 kept;
+
+            for ( size_t i = 0; i < segments; ++i ) {
+                const auto vec_a = points[ 2 * i ];
+                const auto vec_b = points[ 2 * i + 1 ];
+
+                const auto rf = make_rf( i );
+
+                // A segment going on from the previous one starts at its point b (see do_stat)
+                const bool shared = has_kept && kept == vec_a;
+                line_acc acc( vec_a, vec_b, !shared );
+                size_t buffered = 0;
+
+                auto keep = [ & ]( const vec2 &point ) {
+                    kept = point;
+                    has_kept = true;
+
+                    // Runs of points for the SIMD sums
+                    t_kept[ buffered++ ] = point;
+                    if ( buffered == t_kept.size( ) ) {
+                        acc.push( t_kept.data( ), buffered );
+                        buffered = 0;
+                    }
+                };
+
+                if ( shared ) {
+                    keep( kept );
+                }
+
+                // do_fpl's compaction one point late: a point is kept or dropped once the next one is known
+                bool has_pending = false;
+                vec2 pending;
+
+                auto visit = [ & ]( const vec2 &point ) {
+                    if ( has_pending && !( has_kept && kept == pending ) && !mains.is_link( pending, point ) ) {
+                        keep( pending );
+                    }
+
+                    pending = point;
+                    has_pending = true;
+                };
+
+                if ( !no_cutoff( vec_a, vec_b, r, delta ) ) {
+                    generate_each( vec_a, vec_b, r, delta, rf, visit );
+                }
+                else if ( r <= tile_depth ) {
+                    // Small trees (chart 3, low R) by their unrolled instance
+                    const auto count = r <= unrolled_cutoff
+                        ? generate_unrolled( vec_a, vec_b, r, rf, t_tile.data( ) )
+                        : generate_bfs( vec_a, vec_b, r, rf, t_tile.data( ), t_bfs );
+                    for ( size_t n = 0; n < count; ++n ) {
+                        visit( t_tile[ n ] );
+                    }
+                }
+                else {
+                    // Depth-first down to the tiles, then every tile level by level
+                    const auto top = r - tile_depth;
+                    uint64_t k0 = 0;
+                    bool at_a = true;
+                    vec2 left;
+
+                    generate_each( vec_a, vec_b, top, 0, rf, [ & ]( const vec2 &point ) {
+                        if ( at_a ) {
+                            visit( point );
+                            at_a = false;
+                        }
+                        else {
+                            const auto count = generate_bfs( left, point, tile_depth, subtree_rf<decltype( rf )> { rf, top, k0++ }, t_tile.data( ), t_bfs );
+
+                            // Point 0 is the end of the previous tile
+                            for ( size_t n = 1; n < count; ++n ) {
+                                visit( t_tile[ n ] );
+                            }
+                        }
+
+                        left = point;
+                    } );
+                }
+
+                // Point b is always kept
+                keep( pending );
+                acc.push( t_kept.data( ), buffered );
+
+                total.add( acc.sums( ), vec_a, vec_b );
+            }
+
+            return total.result( );
+        }
+    }
+
+    stat stream_stat( const std::vector<vec2> &points, int r, int delta, int gen_type, float stddev, float s, uint64_t seed, uint64_t stream, int prec ) {
+        return stream_segments( points, r, delta, prec, [ & ]( size_t i ) {
+            return segment_rf { gen_type, stddev, s, { seed, stream, segment_id( points[ 2 * i ], points[ 2 * i + 1 ] ) } };
+        } );
+    }
+
+    stat stream_stat( const std::vector<vec2> &points, int r, int delta, float scale, const unit_tree &tree, int prec ) {
+        // Only the levels the tree has
+        r = r < tree.levels( ) ? r : tree.levels( );
+
+        return stream_segments( points, r, delta, prec, [ & ]( size_t i ) {
+            return tree_rf { tree.segment( i ), scale };
+        } );
+    }
+
+    bool unit_tree::fits( size_t segments, int levels ) {
+        return levels >= 0 && levels <= max_depth && segments * ( capacity( levels ) - 2 ) <= budget;
+    }
+
+    void unit_tree::fill( int gen_type, uint64_t seed, uint64_t stream, const std::vector<vec2> &points, int levels ) {
+        const auto segments = points.size( ) / 2;
+
+        // The trees are keyed by the a, b of the segments, not by their count
+        bool same_ids = m_ids.size( ) == segments;
+        for ( size_t i = 0; i < segments && same_ids; ++i ) {
+            same_ids = m_ids[ i ] == segment_id( points[ 2 * i ], points[ 2 * i + 1 ] );
+        }
+
+        if ( m_filled && m_gen_type == gen_type && m_seed == seed && m_stream == stream && same_ids && m_levels == levels ) {
+            return;
+        }
+
+        // 2^levels - 1 nodes per segment
+        const auto nodes = capacity( levels ) - 2;
+        m_values.resize( segments * nodes );
+        m_ids.resize( segments );
+
+        for ( size_t i = 0; i < segments; ++i ) {
+            m_ids[ i ] = segment_id( points[ 2 * i ], points[ 2 * i + 1 ] );
+            const segment_rf rf { gen_type, 1.f, 1.f, { seed, stream, m_ids[ i ] } };
+
+            for ( int l = 0; l < levels; ++l ) {
+                const auto m = size_t( 1 ) << l;
+                rf( l, 0, m, m_values.data( ) + i * nodes + m - 1 );
+            }
+        }
+
+        m_filled = true;
+        m_gen_type = gen_type;
+        m_seed = seed;
+        m_stream = stream;
+        m_levels = levels;
+    }
+
+    const float *unit_tree::segment( size_t i ) const {
+        return m_values.data( ) + i * ( capacity( m_levels ) - 2 );
+    }
+
+    bool get_stats( const std::vector<vec2> &points, const settings &cfg, series &out, pool &workers, const std::atomic<bool> *cancel ) {
+        const auto n = static_cast< size_t >( std::max( cfg.n, 0 ) );
+        if ( n == 0 ) {
+            return true;
+        }
+
+        const auto r = cfg.r;
+        const auto s = cfg.s( );
+
+        // Temporaries of the sweep in the caller's arena, blocks reused by the next call
+        const arena_scope scope;
+
+        // Sweep values for charts 1, 2
+        std::pmr::vector<float> sweep_x( scope.resource( ) );
+
+        // Uniform div: from sj to sj * j
+        if ( cfg.gen_type == gen_uniform ) {
+            for ( int j = 1; j <= cfg.j; ++j ) {
+                sweep_x.push_back( cfg.sj * j );
+            }
+        }
+        // Normal div: from 0 to stddev with step 0.01
+        else if ( cfg.gen_type == gen_normal ) {
+            for ( float i = 0.01f; i <= cfg.stddev; i += 0.01f ) {
+                sweep_x.push_back( i );
+            }
+        }
+        else {
+            return true;
+        }
+
+        // Fixed count of realisations per value if not adaptive
+        const auto n_max = cfg.adaptive ? std::max( static_cast< size_t >( std::max( cfg.n_max, 0 ) ), n ) : n;
+        const auto tol = static_cast< double >( cfg.tol );
+
+        // Every realisation gets its own stream: 1, 2, 3... (0 is the FPL itself)
+        // Charts 1, 2 take the first sweep_x.size( ) * n_max streams, chart 3 the next r * n_max
+        // Common random numbers: realisation i of every value shares stream first_stream + i
+        // (first_stream3 + i on chart 3), the same offsets only scaled or cut at another depth
+        const uint64_t first_stream = 1;
+        const uint64_t first_stream3 = first_stream + ( cfg.crn ? 1 : sweep_x.size( ) ) * n_max;
+
+        auto stream_of = [ & ]( uint64_t first, size_t v, size_t i ) {
+            return cfg.crn ? first + i : first + v * n_max + i;
+        };
+
+        // Stats of the offsets scaled by scale (stddev or s) cut at depth, levels deep trees of the
+        // realisation made once per thread and reused while they fit
+        const auto segments = points.size( ) / 2;
+        auto crn_stat = [ & ]( int depth, int levels, float scale, uint64_t stream ) {
+            thread_local unit_tree t_tree;
+
+            if ( !unit_tree::fits( segments, levels ) ) {
+                return cfg.gen_type == gen_uniform
+                    ? stream_stat( points, depth, cfg.delta, cfg.gen_type, cfg.stddev, scale, cfg.seed, stream, cfg.precision )
+                    : stream_stat( points, depth, cfg.delta, cfg.gen_type, scale, s, cfg.seed, stream, cfg.precision );
+            }
+
+            t_tree.fill( cfg.gen_type, cfg.seed, stream, points, levels );
+            return stream_stat( points, depth, cfg.delta, scale, t_tree, cfg.precision );
+        };
+
+        // Failed to get stats
+        auto failed = [ ]( const stat &st, int line ) {
+            if ( std::get<0>( st ) == 0.f && std::get<1>( st ) == 0.f && std::get<2>( st ) == 0.f ) {
+                std::cout << "[error] stats = 0! Line: " << line << std::endl;
+                return true;
+            }
+
+            return false;
+        };
+
+        // Max, mean, elong of every sweep value
+        std::pmr::vector<std::array<running_stat, 3>> acc( sweep_x.size( ), scope.resource( ) );
+
+        // Makes N's FPL's for every sweep value (all at once, on the pool)
+        const bool ok = adaptive_sweep( workers, sweep_x.size( ), n, n_max, [ & ]( size_t v, size_t i ) {
+            const auto stream = stream_of( first_stream, v, i );
+            if ( cfg.crn ) {
+                return crn_stat( r, r, sweep_x[ v ], stream );
+            }
+
+            // Uniform -> sweep over s, normal -> sweep over stddev
+            // Only the stats are needed, the FPL itself is never made
+            return cfg.gen_type == gen_uniform
+                ? stream_stat( points, r, cfg.delta, cfg.gen_type, cfg.stddev, sweep_x[ v ], cfg.seed, stream, cfg.precision )
+                : stream_stat( points, r, cfg.delta, cfg.gen_type, sweep_x[ v ], s, cfg.seed, stream, cfg.precision );
+        }, [ & ]( size_t v, const stat &st ) {
+            if ( failed( st, __LINE__ ) ) {
+                return false;
+            }
+
+            acc[ v ][ 0 ].add( std::get<0>( st ) );
+            acc[ v ][ 1 ].add( std::get<1>( st ) );
+            acc[ v ][ 2 ].add( std::get<2>( st ) );
+            return true;
+        }, [ & ]( size_t v ) {
+            return acc[ v ][ 0 ].within( tol ) && acc[ v ][ 1 ].within( tol ) && acc[ v ][ 2 ].within( tol );
+        }, cancel, cfg.crn );
+
+        if ( !ok ) {
+            return false;
+        }
+
+        // Chart 3: log2 of the elongation, from 1 to r
+        std::pmr::vector<running_stat> acc3( static_cast< size_t >( std::max( r, 0 ) ), scope.resource( ) );
+
+        const bool ok3 = adaptive_sweep( workers, acc3.size( ), n, n_max, [ & ]( size_t v, size_t i ) {
+            const auto depth = static_cast< int >( v ) + 1;
+            const auto stream = stream_of( first_stream3, v, i );
+
+            // Every depth cuts the same r deep tree
+            if ( cfg.crn ) {
+                return crn_stat( depth, r, cfg.gen_type == gen_uniform ? s : cfg.stddev, stream );
+            }
+
+            return stream_stat( points, depth, cfg.delta, cfg.gen_type, cfg.stddev, s, cfg.seed, stream, cfg.precision );
+        }, [ & ]( size_t v, const stat &st ) {
+            if ( failed( st, __LINE__ ) ) {
+                return false;
+            }
+
+            acc3[ v ].add( std::log2( std::get<2>( st ) ) );
+            return true;
+        }, [ & ]( size_t v ) {
+            return acc3[ v ].within( tol );
+        }, cancel, cfg.crn );
+
+        if ( !ok3 ) {
+            return false;
+        }
+
+        for ( size_t v = 0; v < sweep_x.size( ); ++v ) {
+            const auto &[ st_max, st_mean, st_elong ] = acc[ v ];
+
+            out.x.push_back( sweep_x[ v ] );
+            out.max.push_back( static_cast< float >( st_max.mean ) );
+            out.mean.push_back( static_cast< float >( st_mean.mean ) );
+            out.elong.push_back( static_cast< float >( st_elong.mean ) );
+            out.log2elong.push_back( std::log2( out.elong.back( ) ) );
+
+            // CI of log2 of the average elongation: d log2( e ) = de / ( e ln 2 )
+            out.max_ci.push_back( static_cast< float >( st_max.ci( ) ) );
+            out.mean_ci.push_back( static_cast< float >( st_mean.ci( ) ) );
+            out.elong_ci.push_back( static_cast< float >( st_elong.ci( ) ) );
+            out.log2elong_ci.push_back( static_cast< float >( st_elong.ci( ) / ( st_elong.mean * std::log( 2.0 ) ) ) );
+            out.samples.push_back( static_cast< int >( st_elong.count ) );
+        }
+
+        for ( size_t v = 0; v < acc3.size( ); ++v ) {
+            out.x3.push_back( static_cast< int >( v ) + 1 );
+            out.log2elong3.push_back( static_cast< float >( acc3[ v ].mean ) );
+            out.log2elong3_ci.push_back( static_cast< float >( acc3[ v ].ci( ) ) );
+            out.samples3.push_back( static_cast< int >( acc3[ v ].count ) );
+        }
+
+        return true;
+    }
+}
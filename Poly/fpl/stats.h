@@ -0,0 +1,187 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "generator.h"
+#include "pool.h"
+#include "sweep.h"
+
+namespace fpl {
+    // Series of the charts
+    struct series {
+        // Charts 1, 2: s (uniform) or stddev (normal) -> averages over N realisations
+        std::vector<float> x;
+        std::vector<float> max;
+        std::vector<float> mean;
+        std::vector<float> elong;
+        std::vector<float> log2elong;
+
+        // Half widths of the 95% confidence intervals of the averages above, realisations per value
+        std::vector<float> max_ci;
+        std::vector<float> mean_ci;
+        std::vector<float> elong_ci;
+        std::vector<float> log2elong_ci;
+        std::vector<int> samples;
+
+        // Chart 3: r -> average log2 of the elongation
+        std::vector<int> x3;
+        std::vector<float> log2elong3;
+        std::vector<float> log2elong3_ci;
+        std::vector<int> samples3;
+
+        void clear( ) {
+            x.clear( );
+            max.clear( );
+            mean.clear( );
+            elong.clear( );
+            log2elong.clear( );
+
+            max_ci.clear( );
+            mean_ci.clear( );
+            elong_ci.clear( );
+            log2elong_ci.clear( );
+            samples.clear( );
+
+            x3.clear( );
+            log2elong3.clear( );
+            log2elong3_ci.clear( );
+            samples3.clear( );
+        }
+    };
+
+    // Running mean and variance (Welford)
+    struct running_stat {
+        size_t count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+
+        void add( double value ) {
+            ++count;
+            const auto d = value - mean;
+            mean += d / count;
+            m2 += d * ( value - mean );
+        }
+
+        double variance( ) const {
+            return count > 1 ? m2 / ( count - 1 ) : 0.0;
+        }
+
+        // Half width of the 95% confidence interval of the mean
+        double ci( ) const {
+            return count > 1 ? 1.96 * std::sqrt( variance( ) / count ) : 0.0;
+        }
+
+        // The CI is within tol * |mean|
+        bool within( double tol ) const {
+            return count > 1 && ci( ) <= tol * std::fabs( mean );
+        }
+    };
+
+    // Sums of one pass over a piece of an FPL
+    struct line_sums {
+        // Deviations from the reference line
+        float max_dev = 0.f;
+        float sum_dev = 0.f;
+        size_t count = 0;
+
+        // Length of the polyline
+        float length = 0.f;
+    };
+
+    // Partial sums of line_pass and line_acc: point i >= 1 of a piece and the link into it go to lane ( i - 1 ) % stat_lanes
+    constexpr size_t stat_lanes = 8;
+
+    // Deviations of points[ 0 .. count ) from the line through a and b and the length of the polyline, in one pass
+    // - with_first = false leaves points[ 0 ] out of the deviations (it's the last point of the previous piece)
+    // - for a horizontal ab the deviation is exactly |y - ( a.y + b.y ) / 2|
+    // SSE/AVX when the build has them, scalar otherwise, all give the same floats
+    line_sums line_pass( const vec2 *points, size_t count, const vec2 &a, const vec2 &b, bool with_first = true );
+
+    // line_pass over points given one at a time or in runs, the same sums bit for bit
+    class line_acc {
+    public:
+        line_acc( const vec2 &a, const vec2 &b, bool with_first = true );
+
+        void push( const vec2 &p );
+
+        // Runs of 8 points go through SIMD
+        void push( const vec2 *p, size_t count );
+
+        line_sums sums( ) const;
+
+    private:
+        // Unit normal of ab and its middle point
+        float m_nx, m_ny;
+        vec2 m_c;
+
+        bool m_with_first;
+
+        // Points pushed and the last of them
+        size_t m_count = 0;
+        vec2 m_last;
+
+        float m_dev0 = 0.f, m_max = 0.f;
+        float m_lane_dev[ stat_lanes ] = { };
+        float m_lane_len[ stat_lanes ] = { };
+    };
+
+    // Stats of the FPL built on the main lines src_points (pairs (a, b), a polygon or any other chain too)
+    // ends[ n ] is the index of point b of main segment n in fpl_points (see do_fpl)
+    // Every point deviates from the line of its own main segment, elongation = FPL length / main lines length
+    // Zeros if there are none
+    stat do_stat( const std::vector<vec2> &src_points, const std::vector<vec2> &fpl_points, const std::vector<size_t> &ends );
+
+    // do_stat of an FPL kept in T (do_fpl_in, double or fixed32): the points, the lines and the sums in double,
+    // so the deep levels aren't rounded to float on the way
+    template <typename T>
+    stat do_stat_in( const std::vector<vec2> &src_points, const std::vector<basic_vec2<T>> &fpl_points, const std::vector<size_t> &ends );
+
+    // do_stat( points, do_fpl( points, ..., &ends ), ends ) without making the FPL, the same stats bit for bit
+    // The points go straight into the sums: O( r ) memory plus a fixed tile, nothing allocated per call
+    // prec: double and fixed are do_stat_in( points, do_fpl_in<T>( ... ), ends ) instead
+    stat stream_stat( const std::vector<vec2> &points, int r, int delta, int gen_type, float stddev, float s, uint64_t seed, uint64_t stream,
+                      int prec = prec_float );
+
+    // Unit offsets (stddev or s = 1) of the trees of every main segment of one realisation, levels 0 .. levels - 1
+    // Common random numbers: scaled, one tree serves every sweep value and, cut at R, every R <= levels
+    class unit_tree {
+    public:
+        // Max count of offsets kept (16 MB)
+        static constexpr size_t budget = size_t( 1 ) << 22;
+
+        // True if the trees fit into the budget
+        static bool fits( size_t segments, int levels );
+
+        // Makes the trees of (seed, stream) for the main segments of points, nothing to do if they are the ones kept already
+        void fill( int gen_type, uint64_t seed, uint64_t stream, const std::vector<vec2> &points, int levels );
+
+        // Offsets of main segment i, node k of level l at [ 2^l - 1 + k ]
+        const float *segment( size_t i ) const;
+
+        int levels( ) const {
+            return m_levels;
+        }
+
+    private:
+        bool m_filled = false;
+        int m_gen_type = 0;
+        uint64_t m_seed = 0;
+        uint64_t m_stream = 0;
+        std::vector<uint32_t> m_ids;
+        int m_levels = 0;
+
+        std::vector<float> m_values;
+    };
+
+    // stream_stat with the offsets of tree scaled by scale (stddev or s), the same stats bit for bit
+    // as stream_stat( points, r, delta, gen_type, ... ) with the seed and stream of the tree
+    stat stream_stat( const std::vector<vec2> &points, int r, int delta, float scale, const unit_tree &tree, int prec = prec_float );
+
+    // Monte Carlo sweeps of the charts for the main lines, on the given workers
+    // cfg.n realisations per value, or adaptively cfg.n .. cfg.n_max of them (see settings)
+    // Streams 1, 2, 3... of cfg.seed, so the result doesn't depend on the thread count
+    // Returns false if some realisation had no stats or once *cancel is set (out is left untouched then)
+    bool get_stats( const std::vector<vec2> &points, const settings &cfg, series &out, pool &workers = pool::shared( ), const std::atomic<bool> *cancel = nullptr );
+}
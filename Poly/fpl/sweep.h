@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <tuple>
+#include <vector>
+
+#include "arena.h"
+#include "pool.h"
+
+namespace fpl {
+    // Stats of one realisation: max dev, mean dev, elongation factor
+    using stat = std::tuple<float, float, float>;
+
+    // Monte Carlo sweep: fn( v, i ) for every sweep value v in [0, values) and realisation i in [0, n)
+    // - every (v, i) is one task of the pool, fn must only depend on its arguments
+    //   (seed its own rng stream from them), then the result is the same for any thread count
+    // - once *cancel is set the tasks left are skipped, their stats stay as they were
+    // Writes the stats row by row: out[ v * n + i ], out must hold values * n of them
+    template <typename Fn>
+    void sweep( pool &workers, size_t values, size_t n, Fn &&fn, stat *out, const std::atomic<bool> *cancel = nullptr ) {
+        auto task = [ & ]( size_t task ) {
+            if ( cancel && *cancel ) {
+                return;
+            }
+
+            out[ task ] = fn( task / n, task % n );
+        };
+
+        // By reference: the std::function of run( ) holds a pointer, not a heap copy of the captures
+        workers.run( values * n, std::ref( task ) );
+    }
+
+    // sweep( ) into a new vector, skipped stats are zero
+    template <typename Fn>
+    std::vector<stat> sweep( pool &workers, size_t values, size_t n, Fn &&fn, const std::atomic<bool> *cancel = nullptr ) {
+        std::vector<stat> out( values * n );
+        sweep( workers, values, n, fn, out.data( ), cancel );
+
+        return out;
+    }
+
+    // Adaptive Monte Carlo sweep: n_min realisations of every value, then n_min more at a time
+    // for the values that aren't done( v ) yet, up to n_max of them
+    // - value v always gets realisations i = 0, 1, 2... (fn( v, i ) as in sweep), so the result
+    //   doesn't depend on the thread count
+    // - take( v, stat ) gets them on the caller's thread in (v, i) order, false from it stops the sweep
+    // - by_realisation runs the tasks of a batch realisation by realisation rather than value by value,
+    //   so a thread gets the same i for neighbouring values (what fn can reuse, see unit_tree)
+    // Returns false if take did or once *cancel is set
+    template <typename Fn, typename Take, typename Done>
+    bool adaptive_sweep( pool &workers, size_t values, size_t n_min, size_t n_max, Fn &&fn, Take &&take, Done &&done,
+                         const std::atomic<bool> *cancel = nullptr, bool by_realisation = false ) {
+        if ( n_min == 0 ) {
+            return true;
+        }
+
+        // Realisations done per value, the values still running and the stats of a batch, in the caller's arena
+        const arena_scope scope;
+
+        std::pmr::vector<size_t> count( values, 0, scope.resource( ) );
+        std::pmr::vector<size_t> active( values, scope.resource( ) );
+        std::pmr::vector<size_t> next( scope.resource( ) );
+        std::pmr::vector<stat> stats( scope.resource( ) );
+
+        for ( size_t v = 0; v < values; ++v ) {
+            active[ v ] = v;
+        }
+
+        // Never more than n_min realisations of every value in a batch: no buffer grows after this
+        next.reserve( values );
+        stats.resize( values * n_min );
+
+        while ( !active.empty( ) ) {
+            // The same batch for all of them, never over n_max
+            auto batch = n_min;
+            for ( const auto v : active ) {
+                batch = n_max - count[ v ] < batch ? n_max - count[ v ] : batch;
+            }
+
+            auto task = [ & ]( size_t a, size_t i ) {
+                return fn( active[ a ], count[ active[ a ] ] + i );
+            };
+
+            if ( by_realisation ) {
+                sweep( workers, batch, active.size( ), [ & ]( size_t i, size_t a ) { return task( a, i ); }, stats.data( ), cancel );
+            }
+            else {
+                sweep( workers, active.size( ), batch, task, stats.data( ), cancel );
+            }
+
+            // A cancelled batch is never read: its skipped slots still hold the stats of the batch before
+            if ( cancel && *cancel ) {
+                return false;
+            }
+
+            next.clear( );
+            for ( size_t a = 0; a < active.size( ); ++a ) {
+                const auto v = active[ a ];
+
+                for ( size_t i = 0; i < batch; ++i ) {
+                    if ( !take( v, stats[ by_realisation ? i * active.size( ) + a : a * batch + i ] ) ) {
+                        return false;
+                    }
+                }
+
+                count[ v ] += batch;
+                if ( count[ v ] < n_max && !done( v ) ) {
+                    next.push_back( v );
+                }
+            }
+
+            active.swap( next );
+        }
+
+        return true;
+    }
+}
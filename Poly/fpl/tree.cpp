@@ -0,0 +1,367 @@
+#include "tree.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "bfs.h"
+#include "engine.h"
+
+namespace fpl {
+    size_t fpl_tree::reset( const std::vector<vec2> &points, const settings &cfg ) {
+        // do_fpl reads the parameter of its generator only
+        const bool same_gen = cfg.gen_type == m_cfg.gen_type &&
+            ( cfg.gen_type == gen_normal ? cfg.stddev == m_cfg.stddev : cfg.s( ) == m_cfg.s( ) );
+
+        if ( !m_valid || cfg.delta != m_cfg.delta || cfg.seed != m_cfg.seed || !same_gen ) {
+            m_points.clear( );
+            m_levels.clear( );
+            m_lines.clear( );
+        }
+
+        // Main segment a, b is the tree of key { seed, 0, segment_id( a, b ) }: a main segment with the same
+        // a, b before gives its levels, at any index
+        const auto segments = points.size( ) / 2;
+        const auto old_segments = m_levels.size( );
+
+        std::unordered_map<uint32_t, size_t> old_of;
+        for ( size_t j = 0; j < old_segments; ++j ) {
+            old_of.emplace( segment_id( m_points[ 2 * j ], m_points[ 2 * j + 1 ] ), j );
+        }
+
+        std::vector<std::vector<level>> levels( segments );
+        std::vector<size_t> from( segments, npos ), to( old_segments, npos );
+
+        size_t kept = 0;
+        for ( size_t i = 0; i < segments; ++i ) {
+            const auto &a = points[ 2 * i ];
+            const auto &b = points[ 2 * i + 1 ];
+
+            const auto it = old_of.find( segment_id( a, b ) );
+            if ( it != old_of.end( ) && m_points[ 2 * it->second ] == a && m_points[ 2 * it->second + 1 ] == b ) {
+                // The same a, b twice: a copy of the levels moved already
+                const auto j = it->second;
+                if ( to[ j ] == npos ) {
+                    levels[ i ] = std::move( m_levels[ j ] );
+                    to[ j ] = i;
+                }
+                else {
+                    levels[ i ] = levels[ to[ j ] ];
+                }
+
+                from[ i ] = j;
+                ++kept;
+                continue;
+            }
+
+            // Level 0: the points a, b
+            auto &first = levels[ i ].emplace_back( );
+            first.x = { a.x, b.x };
+            first.y = { a.y, b.y };
+        }
+
+        m_levels = std::move( levels );
+        if ( kept < segments ) {
+            m_depth = 0;
+        }
+
+        // Other main lines: a kept level may compact to other points (at a main link or a seam), the polylines
+        // are patched where it may happen
+        if ( points != m_points ) {
+            mark_stale( points, from );
+        }
+
+        m_points = points;
+        m_cfg = cfg;
+        m_valid = true;
+
+        return kept;
+    }
+
+    void fpl_tree::set_depth( int r, pool *workers ) {
+        if ( r < 0 ) {
+            r = 0;
+        }
+        else if ( r > max_depth ) {
+            r = max_depth;
+        }
+
+        // Tasks of about 16k points
+        parallel_for( workers, m_levels.size( ), ( size_t( 1 ) << 14 ) / capacity( r ), [ & ]( size_t i ) {
+            while ( static_cast< int >( m_levels[ i ].size( ) ) <= r ) {
+                refine( i );
+            }
+        } );
+
+        m_depth = r;
+    }
+
+    int fpl_tree::levels( ) const {
+        if ( m_levels.empty( ) ) {
+            return 0;
+        }
+
+        auto ret = max_depth;
+        for ( const auto &levels : m_levels ) {
+            ret = std::min( ret, static_cast< int >( levels.size( ) ) - 1 );
+        }
+
+        return ret;
+    }
+
+    void fpl_tree::refine( size_t i ) {
+        const auto &a = m_points[ 2 * i ];
+        const auto &b = m_points[ 2 * i + 1 ];
+
+        const segment_rf rf { m_cfg.gen_type, m_cfg.stddev, m_cfg.s( ), { m_cfg.seed, 0, segment_id( a, b ) } };
+
+        auto &levels = m_levels[ i ];
+        const auto l = static_cast< int >( levels.size( ) ) - 1;
+
+        // Grows the vector, cur only after it
+        levels.emplace_back( );
+        const auto &cur = levels[ l ];
+        auto &next = levels[ l + 1 ];
+
+        const auto m = cur.x.size( ) - 1;
+
+        // Nothing can be cut yet: the whole level at once, as generate_bfs does it
+        if ( cur.k.empty( ) && no_cutoff( a, b, l + 1, m_cfg.delta ) ) {
+            // Offsets of a whole level, kept between calls
+            thread_local std::vector<float> t_offsets;
+            t_offsets.resize( m );
+            rf( l, 0, m, t_offsets.data( ) );
+
+            next.x.resize( 2 * m + 1 );
+            next.y.resize( 2 * m + 1 );
+            refine_level( cur.x.data( ), cur.y.data( ), t_offsets.data( ), m, next.x.data( ), next.y.data( ) );
+            return;
+        }
+
+        // Segment by segment with the cutoff, as generate_each does it
+        for ( size_t j = 0; j < m; ++j ) {
+            const auto k = cur.k.empty( ) ? j : cur.k[ j ];
+
+            const vec2 vec_a( cur.x[ j ], cur.y[ j ] );
+            const vec2 vec_b( cur.x[ j + 1 ], cur.y[ j + 1 ] );
+
+            next.x.push_back( vec_a.x );
+            next.y.push_back( vec_a.y );
+
+            auto vec_v = vec_b - vec_a;
+            auto v_len = vec_v.length( );
+
+            // Too short, stays as it is on every level below
+            if ( v_len < m_cfg.delta ) {
+                next.k.push_back( k );
+                continue;
+            }
+
+            auto c = ( vec_a + vec_b ) / 2;
+            auto rotv = vec_v.perp( );
+            auto rf_v = rf( l, k );
+            auto d = vec2( c.x + rf_v * rotv.x, c.y + rf_v * rotv.y );
+
+            next.x.push_back( d.x );
+            next.y.push_back( d.y );
+            next.k.push_back( k * 2 );
+            next.k.push_back( k * 2 + 1 );
+        }
+
+        next.x.push_back( cur.x[ m ] );
+        next.y.push_back( cur.y[ m ] );
+    }
+
+    bool fpl_tree::level::holds( const vec2 &a, const vec2 &b ) {
+        if ( !boxed ) {
+            lo = hi = vec2( x[ 0 ], y[ 0 ] );
+            for ( size_t n = 1; n < x.size( ); ++n ) {
+                lo = vec2( std::min( lo.x, x[ n ] ), std::min( lo.y, y[ n ] ) );
+                hi = vec2( std::max( hi.x, x[ n ] ), std::max( hi.y, y[ n ] ) );
+            }
+
+            boxed = true;
+        }
+
+        auto in = [ & ]( const vec2 &p ) {
+            return p.x >= lo.x && p.x <= hi.x && p.y >= lo.y && p.y <= hi.y;
+        };
+
+        return in( a ) && in( b );
+    }
+
+    void fpl_tree::mark_stale( const std::vector<vec2> &points, const std::vector<size_t> &from ) {
+        const auto segments = points.size( ) / 2;
+
+        // is_link( p, q ) is true only for points p, q next to each other in the main points: the ones of
+        // either main lines where it isn't the same in both
+        const main_index old_mains( m_points );
+        const main_index mains( points );
+
+        std::vector<vec2> links;
+        const std::vector<vec2> *lists[ ] = { &m_points, &points };
+        for ( const auto *list : lists ) {
+            for ( size_t n = 0; n + 1 < list->size( ); ++n ) {
+                const auto &p = ( *list )[ n ];
+                const auto &q = ( *list )[ n + 1 ];
+
+                if ( old_mains.is_link( p, q ) != mains.is_link( p, q ) ) {
+                    links.push_back( p );
+                    links.push_back( q );
+                }
+            }
+        }
+
+        // Every main segment where it was before: the runs stay in place
+        bool in_place = segments == m_points.size( ) / 2;
+        for ( size_t i = 0; i < segments && in_place; ++i ) {
+            in_place = from[ i ] == npos || from[ i ] == i;
+        }
+
+        for ( size_t r = 0; r < m_lines.size( ); ++r ) {
+            auto &line = m_lines[ r ];
+            if ( !line.made ) {
+                continue;
+            }
+
+            std::vector<bool> stale( segments );
+            size_t count = 0;
+            for ( size_t i = 0; i < segments; ++i ) {
+                // New (its levels start over), stale already, its seam point moved or it may hold a link
+                const auto j = from[ i ];
+                stale[ i ] = j == npos || line.stale[ j ];
+
+                if ( !stale[ i ] ) {
+                    const auto *seam = seam_point( points, i );
+                    const auto *old_seam = seam_point( m_points, j );
+                    stale[ i ] = ( seam == nullptr ) != ( old_seam == nullptr ) || ( seam && *seam != *old_seam );
+
+                    for ( size_t n = 0; n < links.size( ) && !stale[ i ]; n += 2 ) {
+                        stale[ i ] = m_levels[ i ][ r ].holds( links[ n ], links[ n + 1 ] );
+                    }
+                }
+
+                count += stale[ i ] ? 1 : 0;
+            }
+
+            // Most of it: made again, not spliced
+            if ( 4 * count > segments ) {
+                line = { };
+                continue;
+            }
+
+            if ( in_place ) {
+                line.stale = std::move( stale );
+                continue;
+            }
+
+            // The kept runs in the new order, point b in place of the run of a new main segment (splice puts it in)
+            fpl_tree::line next;
+            next.ends.resize( segments );
+            for ( size_t i = 0; i < segments; ++i ) {
+                const auto j = from[ i ];
+                if ( j == npos ) {
+                    next.points.push_back( points[ 2 * i + 1 ] );
+                }
+                else {
+                    const auto first = j > 0 ? line.ends[ j - 1 ] + 1 : 0;
+                    next.points.insert( next.points.end( ), line.points.begin( ) + first, line.points.begin( ) + line.ends[ j ] + 1 );
+                }
+
+                next.ends[ i ] = next.points.size( ) - 1;
+            }
+
+            next.stale = std::move( stale );
+            next.made = true;
+            line = std::move( next );
+        }
+    }
+
+    void fpl_tree::splice( line &l, pool *workers ) {
+        std::vector<size_t> stale;
+        for ( size_t i = 0; i < l.stale.size( ); ++i ) {
+            if ( l.stale[ i ] ) {
+                stale.push_back( i );
+            }
+        }
+
+        if ( stale.empty( ) ) {
+            return;
+        }
+
+        // The new runs aside first
+        std::vector<std::vector<vec2>> runs( stale.size( ) );
+        const main_index mains( m_points );
+
+        parallel_for( workers, stale.size( ), 1, [ & ]( size_t t ) {
+            const auto i = stale[ t ];
+            const auto &leaf = m_levels[ i ][ m_depth ];
+
+            runs[ t ].resize( leaf.x.size( ) );
+            runs[ t ].resize( compact_run( mains, seam_point( m_points, i ), leaf.x.data( ), leaf.y.data( ), leaf.x.size( ), runs[ t ].data( ) ) );
+        } );
+
+        // Last one first: the runs before it stay where they are
+        for ( size_t t = stale.size( ); t-- > 0; ) {
+            const auto i = stale[ t ];
+            const auto &run = runs[ t ];
+
+            const auto first = i > 0 ? l.ends[ i - 1 ] + 1 : 0;
+            const auto count = l.ends[ i ] + 1 - first;
+
+            if ( run.size( ) > count ) {
+                l.points.insert( l.points.begin( ) + first + count, run.size( ) - count, vec2( ) );
+            }
+            else {
+                l.points.erase( l.points.begin( ) + first + run.size( ), l.points.begin( ) + first + count );
+            }
+
+            std::copy( run.begin( ), run.end( ), l.points.begin( ) + first );
+
+            for ( size_t j = i; j < l.ends.size( ); ++j ) {
+                l.ends[ j ] = l.ends[ j ] + run.size( ) - count;
+            }
+        }
+
+        l.stale.assign( l.stale.size( ), false );
+    }
+
+    const std::vector<vec2> &fpl_tree::polyline( std::vector<size_t> *ends, pool *workers ) {
+        if ( static_cast< int >( m_lines.size( ) ) <= m_depth ) {
+            m_lines.resize( m_depth + 1 );
+        }
+
+        auto &line = m_lines[ m_depth ];
+        if ( line.made ) {
+            splice( line, workers );
+        }
+        else {
+            // Slots of the leaves, next to each other
+            std::vector<size_t> first( m_levels.size( ) ), count( m_levels.size( ) );
+
+            size_t total = 0;
+            for ( size_t i = 0; i < m_levels.size( ); ++i ) {
+                first[ i ] = total;
+                total += m_levels[ i ][ m_depth ].x.size( );
+            }
+
+            line.points.assign( total, vec2( ) );
+            const main_index mains( m_points );
+
+            parallel_for( workers, m_levels.size( ), ( size_t( 1 ) << 14 ) / capacity( m_depth ), [ & ]( size_t i ) {
+                const auto &leaf = m_levels[ i ][ m_depth ];
+
+                count[ i ] = compact_run( mains, seam_point( m_points, i ), leaf.x.data( ), leaf.y.data( ), leaf.x.size( ), line.points.data( ) + first[ i ] );
+            } );
+
+            pack_runs( line.points, first, count, &line.ends );
+            line.stale.assign( m_levels.size( ), false );
+            line.made = true;
+        }
+
+        if ( ends ) {
+            *ends = line.ends;
+        }
+
+        return line.points;
+    }
+}
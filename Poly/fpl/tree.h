@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../types/vec2.h"
+#include "generator.h"
+#include "pool.h"
+
+namespace fpl {
+    // FPL kept as every level of its midpoint displacement trees (one per main segment)
+    // - a deeper R makes only the levels that aren't there yet, a lower one picks a kept level in O( 1 );
+    //   the upper levels never change (offsets are keyed by node, see segment_rf)
+    // - a main segment that was added or moved is made again, the others keep their levels wherever they are now
+    //   (its tree is keyed by its a, b, see segment_id)
+    // - polyline( ) gives the same points as do_fpl( points, cfg ) with cfg.r = depth( )
+    // - the levels are float, cfg.precision is not read (do_fpl makes the other precisions)
+    class fpl_tree {
+    public:
+        // New main lines and settings: starts over if cfg (all but R) changed, otherwise only the
+        // main segments whose a, b weren't a main segment before start over (at any index, of any count)
+        // depth( ) is 0 again if any of them did, set_depth( ) makes their levels
+        // Returns the count of main segments that kept their levels
+        size_t reset( const std::vector<vec2> &points, const settings &cfg );
+
+        // Current R, the levels up to it are made if they aren't there yet (clamped to 0 .. max_depth)
+        // workers (if any) make the main segments in parallel
+        void set_depth( int r, pool *workers = nullptr );
+
+        int depth( ) const {
+            return m_depth;
+        }
+
+        // Deepest level made so far for every main segment
+        int levels( ) const;
+
+        // FPL of the current depth, compacted as do_fpl does it (by workers, if any)
+        // ends (if any) gets the index of point b of every main segment
+        // Kept per depth: going back to a depth made before makes and copies nothing; after reset( ) only the
+        // runs of the main segments that may compact to other points are made again and spliced in
+        const std::vector<vec2> &polyline( std::vector<size_t> *ends = nullptr, pool *workers = nullptr );
+
+    private:
+        // No main segment
+        static constexpr size_t npos = static_cast< size_t >( -1 );
+
+        // Points of one level of one main segment (SoA) and the tree nodes of its segments
+        // k empty: the whole level was split, segment j is node j
+        struct level {
+            std::vector<float> x, y;
+            std::vector<uint64_t> k;
+
+            // Box of the points (boxed: found already)
+            vec2 lo, hi;
+            bool boxed = false;
+
+            // True if a and b are both in the box
+            bool holds( const vec2 &a, const vec2 &b );
+        };
+
+        // polyline( ) of a depth and its ends, stale: the runs of main segments to compact again
+        struct line {
+            std::vector<vec2> points;
+            std::vector<size_t> ends;
+            std::vector<bool> stale;
+            bool made = false;
+        };
+
+        // Makes the level after the last one of main segment i
+        void refine( size_t i );
+
+        // Main lines going from m_points to points, main segment i of them was from[ i ] of m_points (npos: new)
+        // Marks the runs that may change in every line, moves the others to the new order
+        void mark_stale( const std::vector<vec2> &points, const std::vector<size_t> &from );
+
+        // Compacts the stale runs of a line again and puts them in place of the old ones
+        void splice( line &l, pool *workers );
+
+        std::vector<vec2> m_points;
+        settings m_cfg;
+        bool m_valid = false;
+
+        // Levels of every main segment: m_levels[ i ][ l ]
+        std::vector<std::vector<level>> m_levels;
+        int m_depth = 0;
+
+        // m_lines[ r ] for every depth r asked for so far
+        std::vector<line> m_lines;
+    };
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "../types/vec2.h"
+#include "bfs.h"
+#include "engine.h"
+
+namespace fpl {
+    // Deepest R with an unrolled instance
+    constexpr int unrolled_depth = 5;
+
+    // Deepest R do_fpl and stream_stat make by the unrolled instance: 1.1 .. 1.3x of generate_bfs up to R 3,
+    // R 4 and 5 are within noise of its SIMD kernels (bench_unrolled, SSE and AVX2)
+    constexpr int unrolled_cutoff = 3;
+
+    // Node K of level L of the tree of depth R, on ab: its middle point goes to out[ ( 2K + 1 ) * 2^( R - L - 1 ) ],
+    // its offset is offsets[ 2^L - 1 + K ]. Every index is a constant, the subtrees are made right here
+    template <int R, int L, uint64_t K>
+    void unrolled_node( const vec2 &a, const vec2 &b, const float *offsets, vec2 *out ) {
+        if constexpr ( L < R ) {
+            constexpr auto half = size_t( 1 ) << ( R - L - 1 );
+
+            // The same ops as generate_each
+            const auto vec_v = b - a;
+            const auto c = ( a + b ) / 2;
+            const auto rotv = vec_v.perp( );
+            const auto rf_v = offsets[ ( size_t( 1 ) << L ) - 1 + K ];
+            const auto d = vec2( c.x + rf_v * rotv.x, c.y + rf_v * rotv.y );
+
+            out[ ( 2 * K + 1 ) * half ] = d;
+
+            unrolled_node<R, L + 1, 2 * K>( a, d, offsets, out );
+            unrolled_node<R, L + 1, 2 * K + 1>( d, b, offsets, out );
+        }
+    }
+
+    // The full tree of depth R on ab from the offsets of its nodes (level order), capacity( R ) points to out
+    template <int R>
+    void generate_unrolled_r( const vec2 &a, const vec2 &b, const float *offsets, vec2 *out ) {
+        out[ 0 ] = a;
+        out[ size_t( 1 ) << R ] = b;
+        unrolled_node<R, 0, 0>( a, b, offsets, out );
+    }
+
+    using unrolled_fn = void ( * )( const vec2 &, const vec2 &, const float *, vec2 * );
+
+    template <size_t... R>
+    constexpr std::array<unrolled_fn, sizeof...( R )> make_unrolled_table( std::index_sequence<R...> ) {
+        return { &generate_unrolled_r<static_cast< int >( R )>... };
+    }
+
+    // generate_unrolled_r<R> at [ R ], R = 0 .. unrolled_depth
+    inline constexpr auto unrolled_table = make_unrolled_table( std::make_index_sequence<unrolled_depth + 1>( ) );
+
+    // generate_bfs for r <= unrolled_depth by the instance of r: no levels in buffers, no loops over the nodes
+    // - rf as in generate_bfs, the same points
+    // - out must hold at least capacity( r ) points
+    // Returns the count of points written (always capacity( r ))
+    template <typename Rf>
+    size_t generate_unrolled( const vec2 &a, const vec2 &b, int r, Rf &&rf, vec2 *out ) {
+        if ( r < 0 ) {
+            r = 0;
+        }
+        else if ( r > unrolled_depth ) {
+            r = unrolled_depth;
+        }
+
+        float offsets[ ( size_t( 1 ) << unrolled_depth ) - 1 ];
+        fill_offsets( r, rf, offsets );
+
+        unrolled_table[ r ]( a, b, offsets, out );
+        return capacity( r );
+    }
+}
@@ -0,0 +1,336 @@
+#include "polyline.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace render {
+    namespace {
+        // Cohen-Sutherland outcode of p against the rect
+        int outcode( const ImVec2 &p, const ImVec2 &min, const ImVec2 &max ) {
+            int code = 0;
+            code |= p.x < min.x ? 1 : 0;
+            code |= p.x > max.x ? 2 : 0;
+            code |= p.y < min.y ? 4 : 0;
+            code |= p.y > max.y ? 8 : 0;
+            return code;
+        }
+    }
+
+    void lod_cache::update( const std::vector<vec2> &points, uint64_t rev, const ImVec2 &origin, float scale, const ImVec2 &clip_min, const ImVec2 &clip_max ) {
+        if ( m_valid && m_rev == rev && m_scale == scale
+             && m_origin.x == origin.x && m_origin.y == origin.y
+             && m_clip_min.x == clip_min.x && m_clip_min.y == clip_min.y
+             && m_clip_max.x == clip_max.x && m_clip_max.y == clip_max.y ) {
+            return;
+        }
+
+        m_rev = rev;
+        m_origin = origin;
+        m_scale = scale;
+        m_clip_min = clip_min;
+        m_clip_max = clip_max;
+        m_valid = true;
+
+        // A pixel of margin, so lines on the border are kept
+        const ImVec2 min( clip_min.x - 1.f, clip_min.y - 1.f );
+        const ImVec2 max( clip_max.x + 1.f, clip_max.y + 1.f );
+
+        // Runs while they stay within max_spans points per column, spans past that
+        const auto columns = static_cast< int >( std::floor( max.x ) - std::floor( min.x ) ) + 1;
+
+        m_spans_mode = !build_runs( points, min, max, max_spans * columns );
+        if ( m_spans_mode ) {
+            build_spans( points, min, max );
+        }
+    }
+
+    bool lod_cache::build_runs( const std::vector<vec2> &points, const ImVec2 &min, const ImVec2 &max, int budget ) {
+        m_points.resize( 0 );
+        m_pieces.resize( 0 );
+        m_run.count = 0;
+
+        ImVec2 prev;
+        int prev_code = 0;
+        bool in_piece = false;
+
+        for ( size_t i = 0; i < points.size( ); ++i ) {
+            const ImVec2 cur( m_origin.x + points[ i ].x * m_scale, m_origin.y + points[ i ].y * m_scale );
+            const int code = outcode( cur, min, max );
+
+            if ( i > 0 ) {
+                // Both ends on the same outer side -> the segment can't be seen
+                if ( ( prev_code & code ) != 0 ) {
+                    if ( in_piece ) {
+                        end_piece( );
+                        in_piece = false;
+                    }
+                }
+                else {
+                    if ( !in_piece ) {
+                        m_pieces.push_back( { m_points.Size, 0 } );
+                        push( prev );
+                        in_piece = true;
+                    }
+
+                    push( cur );
+
+                    if ( m_points.Size > budget ) {
+                        return false;
+                    }
+                }
+            }
+
+            prev = cur;
+            prev_code = code;
+        }
+
+        if ( in_piece ) {
+            end_piece( );
+        }
+
+        return m_points.Size <= budget;
+    }
+
+    void lod_cache::build_spans( const std::vector<vec2> &points, const ImVec2 &min, const ImVec2 &max ) {
+        m_points.resize( 0 );
+        m_pieces.resize( 0 );
+        m_run.count = 0;
+
+        m_col0 = static_cast< int >( std::floor( min.x ) );
+        const auto columns = static_cast< int >( std::floor( max.x ) ) - m_col0 + 1;
+
+        m_spans.resize( columns * max_spans );
+        m_span_count.resize( columns );
+        std::fill( m_span_count.begin( ), m_span_count.end( ), 0 );
+
+        ImVec2 prev;
+        int prev_code = 0;
+
+        for ( size_t i = 0; i < points.size( ); ++i ) {
+            const ImVec2 cur( m_origin.x + points[ i ].x * m_scale, m_origin.y + points[ i ].y * m_scale );
+            const int code = outcode( cur, min, max );
+
+            if ( i > 0 && ( prev_code & code ) == 0 ) {
+                cover( prev, cur, min, max );
+            }
+
+            prev = cur;
+            prev_code = code;
+        }
+
+        // A vertical piece through the middle of the column per span, a pixel long at least
+        for ( int c = 0; c < columns; ++c ) {
+            const auto x = static_cast< float >( m_col0 + c ) + 0.5f;
+
+            for ( int j = 0; j < m_span_count[ c ]; ++j ) {
+                const auto &sp = m_spans[ c * max_spans + j ];
+
+                m_pieces.push_back( { m_points.Size, 2 } );
+                m_points.push_back( ImVec2( x, sp.min ) );
+                m_points.push_back( ImVec2( x, std::max( sp.max, sp.min + 1.f ) ) );
+            }
+        }
+    }
+
+    void lod_cache::cover( const ImVec2 &p, const ImVec2 &q, const ImVec2 &min, const ImVec2 &max ) {
+        const auto &l = p.x <= q.x ? p : q;
+        const auto &r = p.x <= q.x ? q : p;
+
+        const auto lo = std::max( l.x, min.x );
+        const auto hi = std::min( r.x, max.x );
+        if ( lo > hi ) {
+            return;
+        }
+
+        const auto dx = r.x - l.x;
+        auto y_at = [ & ]( float x ) {
+            return dx > 0.f ? l.y + ( r.y - l.y ) * ( ( x - l.x ) / dx ) : l.y;
+        };
+
+        const auto c0 = static_cast< int >( std::floor( lo ) );
+        const auto c1 = static_cast< int >( std::floor( hi ) );
+
+        for ( int c = c0; c <= c1; ++c ) {
+            // Where the segment enters and leaves the column (both ends if it's vertical)
+            auto y0 = dx > 0.f ? y_at( std::max( lo, static_cast< float >( c ) ) ) : l.y;
+            auto y1 = dx > 0.f ? y_at( std::min( hi, static_cast< float >( c + 1 ) ) ) : r.y;
+            if ( y0 > y1 ) {
+                std::swap( y0, y1 );
+            }
+
+            if ( y1 < min.y || y0 > max.y ) {
+                continue;
+            }
+
+            add_span( c, std::max( y0, min.y ), std::min( y1, max.y ) );
+        }
+    }
+
+    void lod_cache::add_span( int col, float y0, float y1 ) {
+        const auto c = col - m_col0;
+        if ( c < 0 || c >= m_span_count.Size ) {
+            return;
+        }
+
+        auto *spans = m_spans.Data + c * max_spans;
+        auto &count = m_span_count[ c ];
+
+        // Merged with every span it overlaps or comes within a pixel of (they're more than a pixel apart
+        // from each other, so nothing else can touch the merged one), the rest stays sorted by y
+        span cur { y0, y1 };
+        span out[ max_spans + 1 ];
+        int n = 0;
+
+        for ( int j = 0; j < count; ++j ) {
+            const auto &sp = spans[ j ];
+            if ( sp.max + 1.f < cur.min || cur.max + 1.f < sp.min ) {
+                out[ n++ ] = sp;
+            }
+            else {
+                cur.min = std::min( cur.min, sp.min );
+                cur.max = std::max( cur.max, sp.max );
+            }
+        }
+
+        int at = n++;
+        while ( at > 0 && out[ at - 1 ].min > cur.min ) {
+            out[ at ] = out[ at - 1 ];
+            --at;
+        }
+
+        out[ at ] = cur;
+
+        // Too many stretches in one column: the closest two become one (the gap between them is drawn too)
+        if ( n > max_spans ) {
+            int best = 0;
+            for ( int j = 1; j + 1 < n; ++j ) {
+                if ( out[ j + 1 ].min - out[ j ].max < out[ best + 1 ].min - out[ best ].max ) {
+                    best = j;
+                }
+            }
+
+            out[ best ].max = std::max( out[ best ].max, out[ best + 1 ].max );
+            for ( int j = best + 1; j + 1 < n; ++j ) {
+                out[ j ] = out[ j + 1 ];
+            }
+
+            --n;
+        }
+
+        std::copy( out, out + n, spans );
+        count = n;
+    }
+
+    void lod_cache::push( const ImVec2 &p ) {
+        const auto col = static_cast< int >( std::floor( p.x ) );
+        auto &r = m_run;
+
+        if ( r.count > 0 && r.col == col ) {
+            if ( p.y < r.min.y ) {
+                r.min = p;
+                r.min_n = r.count;
+            }
+
+            if ( p.y > r.max.y ) {
+                r.max = p;
+                r.max_n = r.count;
+            }
+
+            r.last = p;
+            ++r.count;
+            return;
+        }
+
+        flush( );
+
+        r.first = r.last = r.min = r.max = p;
+        r.min_n = r.max_n = 0;
+        r.col = col;
+        r.count = 1;
+    }
+
+    void lod_cache::flush( ) {
+        const auto &r = m_run;
+        if ( r.count == 0 ) {
+            return;
+        }
+
+        m_points.push_back( r.first );
+
+        // Extremes in the order they came, without repeating first and last
+        const auto last_n = r.count - 1;
+        const bool min_first = r.min_n <= r.max_n;
+        const int n_a = min_first ? r.min_n : r.max_n;
+        const int n_b = min_first ? r.max_n : r.min_n;
+
+        if ( n_a != 0 && n_a != last_n ) {
+            m_points.push_back( min_first ? r.min : r.max );
+        }
+
+        if ( n_b != n_a && n_b != 0 && n_b != last_n ) {
+            m_points.push_back( min_first ? r.max : r.min );
+        }
+
+        if ( last_n > 0 ) {
+            m_points.push_back( r.last );
+        }
+
+        m_run.count = 0;
+    }
+
+    void lod_cache::end_piece( ) {
+        flush( );
+
+        auto &p = m_pieces.back( );
+        p.count = m_points.Size - p.first;
+    }
+
+    void draw_polyline( ImDrawList *draw_list, const ImVec2 *points, int count, ImU32 col, float thickness ) {
+        // Neighbour batches share one point so the line stays connected
+        for ( int first = 0; first + 1 < count; first += max_batch - 1 ) {
+            const auto n = std::min( max_batch, count - first );
+            draw_list->AddPolyline( points + first, n, col, ImDrawFlags_None, thickness );
+        }
+    }
+
+    void draw_thin_polyline( ImDrawList *draw_list, const ImVec2 *points, int count, ImU32 col ) {
+        const auto uv = ImGui::GetFontTexUvWhitePixel( );
+
+        for ( int first = 0; first + 1 < count; first += max_batch - 1 ) {
+            const auto n = std::min( max_batch, count - first );
+            draw_list->PrimReserve( ( n - 1 ) * 6, n * 2 );
+
+            // Strip of quads: every point gives 2 vertices, shared by its two segments
+            const auto base = draw_list->_VtxCurrentIdx;
+            for ( int i = 0; i + 1 < n; ++i ) {
+                const auto idx = static_cast< ImDrawIdx >( base + i * 2 );
+                draw_list->PrimWriteIdx( idx );
+                draw_list->PrimWriteIdx( static_cast< ImDrawIdx >( idx + 1 ) );
+                draw_list->PrimWriteIdx( static_cast< ImDrawIdx >( idx + 3 ) );
+                draw_list->PrimWriteIdx( idx );
+                draw_list->PrimWriteIdx( static_cast< ImDrawIdx >( idx + 3 ) );
+                draw_list->PrimWriteIdx( static_cast< ImDrawIdx >( idx + 2 ) );
+            }
+
+            for ( int i = 0; i < n; ++i ) {
+                const auto &p = points[ first + i ];
+
+                // Half a pixel to both sides of the outgoing segment (incoming one for the last point)
+                const auto &a = i + 1 < n ? p : points[ first + i - 1 ];
+                const auto &b = i + 1 < n ? points[ first + i + 1 ] : p;
+
+                auto dx = b.x - a.x;
+                auto dy = b.y - a.y;
+                const auto len2 = dx * dx + dy * dy;
+                if ( len2 > 0.f ) {
+                    const auto inv = 0.5f / std::sqrt( len2 );
+                    dx *= inv;
+                    dy *= inv;
+                }
+
+                draw_list->PrimWriteVtx( ImVec2( p.x - dy, p.y + dx ), uv, col );
+                draw_list->PrimWriteVtx( ImVec2( p.x + dy, p.y - dx ), uv, col );
+            }
+        }
+    }
+}
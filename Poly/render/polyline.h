@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../imgui/imgui.h"
+#include "../types/vec2.h"
+
+namespace render {
+    // Points per draw call, keeps every call far below the 16-bit index limit
+    constexpr int max_batch = 8192;
+
+    // From this count of FPL points (before decimation) the thin path is used (if enabled)
+    constexpr size_t thin_line_threshold = 50000;
+
+    // Most separate stretches of the line kept per pixel column when it's drawn as spans
+    constexpr int max_spans = 8;
+
+    // Screen-space, view-dependent copy of a polyline for drawing
+    // - clipped to the view rect first: segments fully outside are dropped and the line is split there
+    // - then decimated per pixel column: a run of consecutive points inside one column becomes
+    //   first, min y, max y, last. That covers the same pixels
+    // - a line crossing columns back and forth starts a run per crossing, so once the runs give more than
+    //   max_spans points per column of the view, the whole line is drawn as spans instead: every column keeps
+    //   the y ranges the line covers in it, stretches less than a pixel apart merged (more than max_spans
+    //   of them -> the closest ones), every range is a piece of 2 points
+    // Either way at most 2 * max_spans points per column of the view, whatever the count of source points is
+    // Rebuilt only when the polyline or the view (origin, scale, clip rect) changes
+    class lod_cache {
+    public:
+        // Part of the line between two clipped off stretches
+        struct piece {
+            int first;
+            int count;
+        };
+
+        // rev must change whenever the points do, scale is screen px per unit of points
+        void update( const std::vector<vec2> &points, uint64_t rev, const ImVec2 &origin, float scale, const ImVec2 &clip_min, const ImVec2 &clip_max );
+
+        const ImVector<ImVec2> &points( ) const {
+            return m_points;
+        }
+
+        const ImVector<piece> &pieces( ) const {
+            return m_pieces;
+        }
+
+        // True if the line is drawn as spans of columns
+        bool spans( ) const {
+            return m_spans_mode;
+        }
+
+        void clear( ) {
+            m_points.clear( );
+            m_pieces.clear( );
+            m_valid = false;
+        }
+
+    private:
+        // Current run of points in one pixel column
+        struct run {
+            ImVec2 first, last, min, max;
+            int min_n, max_n;
+            int col;
+            int count;
+        };
+
+        // y range of the line in a column
+        struct span {
+            float min, max;
+        };
+
+        // Clipped, decimated pieces in m_points, false once they're over budget points
+        bool build_runs( const std::vector<vec2> &points, const ImVec2 &min, const ImVec2 &max, int budget );
+        void build_spans( const std::vector<vec2> &points, const ImVec2 &min, const ImVec2 &max );
+
+        void push( const ImVec2 &p );
+        void flush( );
+        void end_piece( );
+
+        // The y range segment pq covers in every column, within min, max
+        void cover( const ImVec2 &p, const ImVec2 &q, const ImVec2 &min, const ImVec2 &max );
+        void add_span( int col, float y0, float y1 );
+
+        ImVector<ImVec2> m_points;
+        ImVector<piece> m_pieces;
+        run m_run {};
+
+        // Spans of column m_col0 + c at [ c * max_spans ], m_span_count[ c ] of them, sorted by y
+        ImVector<span> m_spans;
+        ImVector<int> m_span_count;
+        int m_col0 = 0;
+        bool m_spans_mode = false;
+
+        // Key of the cached view
+        uint64_t m_rev = 0;
+        ImVec2 m_origin, m_clip_min, m_clip_max;
+        float m_scale = 0.f;
+        bool m_valid = false;
+    };
+
+    // AddPolyline in batches of max_batch points
+    void draw_polyline( ImDrawList *draw_list, const ImVec2 *points, int count, ImU32 col, float thickness );
+
+    // 1 px quad strip straight through PrimReserve: no AA fringe, no joins, 2 vertices per point
+    void draw_thin_polyline( ImDrawList *draw_list, const ImVec2 *points, int count, ImU32 col );
+}
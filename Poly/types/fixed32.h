@@ -0,0 +1,142 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+// Signed 16.16 fixed point: the same 2^-16 step everywhere in -32768 .. 32768,
+// where a float has 2^-10 at 8192 already
+// Products and quotients go through 64 bits and are rounded to the nearest step
+// Out of range values saturate to lowest( ) / highest( ) (on the way in too), they never wrap
+class fixed32 {
+public:
+	static constexpr int frac_bits = 16;
+	static constexpr int32_t one = int32_t( 1 ) << frac_bits;
+
+	static constexpr int32_t raw_min = INT32_MIN;
+	static constexpr int32_t raw_max = INT32_MAX;
+
+	constexpr fixed32( ) : raw( 0 ) {
+	}
+
+	// Integers only: a float is never truncated on the way in
+	template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+	constexpr fixed32( I i ) : raw( saturate( static_cast< double >( i ) * one ) ) {
+	}
+
+	// NaN -> 0
+	constexpr explicit fixed32( double d ) : raw( saturate( d * one + ( d < 0.0 ? -0.5 : 0.5 ) ) ) {
+	}
+
+	constexpr explicit fixed32( float f ) : fixed32( static_cast< double >( f ) ) {
+	}
+
+	static constexpr fixed32 from_raw( int32_t r ) {
+		fixed32 ret;
+		ret.raw = r;
+		return ret;
+	}
+
+	static constexpr fixed32 lowest( ) {
+		return from_raw( raw_min );
+	}
+
+	static constexpr fixed32 highest( ) {
+		return from_raw( raw_max );
+	}
+
+	// Raw value clamped to int32 (truncated toward zero)
+	static constexpr int32_t saturate( int64_t r ) {
+		return r < raw_min ? raw_min : r > raw_max ? raw_max : static_cast< int32_t >( r );
+	}
+
+	static constexpr int32_t saturate( double r ) {
+		return r < raw_min ? raw_min : r > raw_max ? raw_max : r == r ? static_cast< int32_t >( r ) : 0;
+	}
+
+	constexpr explicit operator double( ) const {
+		return static_cast< double >( raw ) / one;
+	}
+
+	constexpr explicit operator float( ) const {
+		return static_cast< float >( static_cast< double >( *this ) );
+	}
+
+	int32_t raw;
+
+	constexpr fixed32 operator-( ) const {
+		return from_raw( saturate( -static_cast< int64_t >( raw ) ) );
+	}
+
+	friend constexpr fixed32 operator+( fixed32 a, fixed32 b ) {
+		return from_raw( saturate( static_cast< int64_t >( a.raw ) + b.raw ) );
+	}
+
+	friend constexpr fixed32 operator-( fixed32 a, fixed32 b ) {
+		return from_raw( saturate( static_cast< int64_t >( a.raw ) - b.raw ) );
+	}
+
+	friend constexpr fixed32 operator*( fixed32 a, fixed32 b ) {
+		const auto p = static_cast< int64_t >( a.raw ) * b.raw;
+		return from_raw( saturate( ( p + ( int64_t( 1 ) << ( frac_bits - 1 ) ) ) >> frac_bits ) );
+	}
+
+	// A float factor times a point coordinate, rounded once (the factor isn't cut to 16.16 first)
+	friend constexpr fixed32 operator*( float f, fixed32 a ) {
+		const auto p = static_cast< double >( f ) * a.raw;
+		return from_raw( saturate( p + ( p < 0.0 ? -0.5 : 0.5 ) ) );
+	}
+
+	// x / 0 -> lowest( ) or highest( ) by the sign of x (0 for 0)
+	friend constexpr fixed32 operator/( fixed32 a, fixed32 b ) {
+		const auto n = static_cast< int64_t >( a.raw ) * one;
+		const auto d = static_cast< int64_t >( b.raw );
+
+		if ( d == 0 ) {
+			return from_raw( n < 0 ? raw_min : n > 0 ? raw_max : 0 );
+		}
+
+		// Half away from zero
+		const auto q = ( ( n < 0 ? -n : n ) + ( d < 0 ? -d : d ) / 2 ) / ( d < 0 ? -d : d );
+		return from_raw( saturate( ( n < 0 ) != ( d < 0 ) ? -q : q ) );
+	}
+
+	fixed32 &operator+=( fixed32 v ) {
+		return *this = *this + v;
+	}
+
+	fixed32 &operator-=( fixed32 v ) {
+		return *this = *this - v;
+	}
+
+	fixed32 &operator*=( fixed32 v ) {
+		return *this = *this * v;
+	}
+
+	fixed32 &operator/=( fixed32 v ) {
+		return *this = *this / v;
+	}
+
+	friend constexpr bool operator==( fixed32 a, fixed32 b ) {
+		return a.raw == b.raw;
+	}
+
+	friend constexpr bool operator!=( fixed32 a, fixed32 b ) {
+		return a.raw != b.raw;
+	}
+
+	friend constexpr bool operator<( fixed32 a, fixed32 b ) {
+		return a.raw < b.raw;
+	}
+
+	friend constexpr bool operator>( fixed32 a, fixed32 b ) {
+		return a.raw > b.raw;
+	}
+
+	friend constexpr bool operator<=( fixed32 a, fixed32 b ) {
+		return a.raw <= b.raw;
+	}
+
+	friend constexpr bool operator>=( fixed32 a, fixed32 b ) {
+		return a.raw >= b.raw;
+	}
+};
@@ -1,105 +1,125 @@
 #pragma once
 #include <cmath>
+#include <type_traits>
 
+#include "fixed32.h"
+
+#ifndef M_PI
 constexpr auto M_PI = 3.14159265358979323846f;
+#endif
 
-class vec2 {
+// Point of T: float (vec2), double (vec2d) or 16.16 fixed point (vec2q)
+template <typename T>
+class basic_vec2 {
 public:
-	vec2( ) {
-		x = y = 0.f;
+	constexpr basic_vec2( ) : x( 0 ), y( 0 ) {
+	}
+
+	constexpr basic_vec2( T fx, T fy ) : x( fx ), y( fy ) {
 	}
 
-	vec2( float fx, float fy ) {
-		x = fx;
-		y = fy;
+	// The same point in another precision (rounded to the nearest one)
+	template <typename U>
+	constexpr explicit basic_vec2( const basic_vec2<U> &v ) : x( static_cast< T >( v.x ) ), y( static_cast< T >( v.y ) ) {
 	}
 
-	float x, y;
+	T x, y;
 
-	vec2 operator+( const vec2 &input ) const {
-		return vec2 { x + input.x, y + input.y };
+	constexpr basic_vec2 operator+( const basic_vec2 &input ) const {
+		return basic_vec2 { x + input.x, y + input.y };
 	}
 
-	vec2 operator-( const vec2 &input ) const {
-		return vec2 { x - input.x, y - input.y };
+	constexpr basic_vec2 operator-( const basic_vec2 &input ) const {
+		return basic_vec2 { x - input.x, y - input.y };
 	}
 
-	vec2 operator+( const int input ) const {
-		return vec2 { x + input, y + input };
+	constexpr basic_vec2 operator+( const int input ) const {
+		return basic_vec2 { x + T( input ), y + T( input ) };
 	}
 
-	vec2 operator-( const int input ) const {
-		return vec2 { x - input, y - input };
+	constexpr basic_vec2 operator-( const int input ) const {
+		return basic_vec2 { x - T( input ), y - T( input ) };
 	}
 
-	vec2 operator/( float input ) const {
-		return vec2 { x / input, y / input };
+	constexpr basic_vec2 operator/( T input ) const {
+		return basic_vec2 { x / input, y / input };
 	}
 
-	vec2 operator*( float input ) const {
-		return vec2 { x * input, y * input };
+	constexpr basic_vec2 operator*( T input ) const {
+		return basic_vec2 { x * input, y * input };
 	}
 
-	vec2 &operator-=( const vec2 &v ) {
+	constexpr basic_vec2 &operator-=( const basic_vec2 &v ) {
 		x -= v.x;
 		y -= v.y;
 		return *this;
 	}
 
-	vec2 &operator/=( float input ) {
+	constexpr basic_vec2 &operator/=( T input ) {
 		x /= input;
 		y /= input;
 		return *this;
 	}
 
-	vec2 &operator*=( float input ) {
+	constexpr basic_vec2 &operator*=( T input ) {
 		x *= input;
 		y *= input;
 		return *this;
 	}
 
-	bool operator==( const vec2 &v ) {
+	constexpr bool operator==( const basic_vec2 &v ) const {
 		return ( x == v.x ) && ( y == v.y );
 	}
 
-	bool operator!=( const vec2 &v ) {
+	constexpr bool operator!=( const basic_vec2 &v ) const {
 		return ( x != v.x ) || ( y != v.y );
 	}
 
-	float length( ) const {
-		return std::sqrt( ( x * x ) + ( y * y ) );
+	// Fixed point: in double, x * x is out of range from 182 on
+	T length( ) const {
+		if constexpr ( std::is_floating_point_v<T> ) {
+			return std::sqrt( ( x * x ) + ( y * y ) );
+		}
+		else {
+			return T( std::hypot( static_cast< double >( x ), static_cast< double >( y ) ) );
+		}
 	}
 
-	vec2 normalized( ) const {
-		return { x / length( ), y / length( ) };
+	basic_vec2 normalized( ) const {
+		const auto len = length( );
+		return { x / len, y / len };
 	}
 
-	float dot_product( vec2 input ) const {
+	constexpr T dot_product( basic_vec2 input ) const {
 		return ( x * input.x ) + ( y * input.y );
 	}
 
-	float distance( vec2 input ) const {
+	T distance( basic_vec2 input ) const {
 		return ( *this - input ).length( );
 	}
 
-	bool empty( ) const {
-		return x == 0.f && y == 0.f;
+	constexpr bool empty( ) const {
+		return x == T( 0 ) && y == T( 0 );
 	}
 
-	vec2 rotate( const float &f ) {
-		float _x, _y;
+	// Rotated by exactly 90 degrees counterclockwise, rotate( 90.f ) goes through sin/cos
+	constexpr basic_vec2 perp( ) const {
+		return { -y, x };
+	}
 
-		float s, c;
+	// Rotated by f degrees counterclockwise
+	basic_vec2 rotate( float f ) const {
+		const float r = f * M_PI / 180.0f;
+		const auto s = T( std::sin( r ) );
+		const auto c = T( std::cos( r ) );
 
-		float r = f * M_PI / 180.0f;
-		s = sin( r );
-		c = cos( r );
+		return { ( x * c ) - ( y * s ), ( x * s ) + ( y * c ) };
+	}
+};
 
-		_x = x;
-		_y = y;
+using vec2 = basic_vec2<float>;
+using vec2d = basic_vec2<double>;
+using vec2q = basic_vec2<fixed32>;
 
-		float nx = ( _x * c ) - ( _y * s );
-		float ny = ( _x * s ) + ( _y * c );
-		return { nx, ny };
-	}
-};
\ No newline at end of file
+// Two floats and nothing else: arrays of vec2 are read as x0 y0 x1 y1 ... (see vec2x.h)
+static_assert( std::is_trivially_copyable_v<vec2> && std::is_standard_layout_v<vec2> && sizeof( vec2 ) == 2 * sizeof( float ) );
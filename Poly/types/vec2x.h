@@ -0,0 +1,398 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+#include "vec2.h"
+
+// FPL_NO_SIMD forces the portable path
+#if defined( FPL_NO_SIMD )
+#elif defined( __AVX2__ ) || defined( __AVX__ )
+#include <immintrin.h>
+#define VEC2X_AVX
+#define VEC2X_SSE
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define VEC2X_SSE
+#endif
+
+// N floats, one per lane: f32x4 is an SSE register, f32x8 an AVX one (two SSE ones without AVX),
+// plain arrays without SIMD. Every op is the same IEEE op on every lane (no FMA), so all paths give the same floats
+// but rsqrt( ), which is an estimate refined by one Newton step on SSE/AVX
+template <size_t N>
+struct f32xn {
+	float v[ N ];
+
+	static f32xn set( float f ) {
+		f32xn ret;
+		for ( size_t j = 0; j < N; ++j ) {
+			ret.v[ j ] = f;
+		}
+
+		return ret;
+	}
+
+	static f32xn load( const float *p ) {
+		f32xn ret;
+		for ( size_t j = 0; j < N; ++j ) {
+			ret.v[ j ] = p[ j ];
+		}
+
+		return ret;
+	}
+
+	void store( float *p ) const {
+		for ( size_t j = 0; j < N; ++j ) {
+			p[ j ] = v[ j ];
+		}
+	}
+
+	template <typename Op>
+	friend f32xn each( const f32xn &a, const f32xn &b, Op &&op ) {
+		f32xn ret;
+		for ( size_t j = 0; j < N; ++j ) {
+			ret.v[ j ] = op( a.v[ j ], b.v[ j ] );
+		}
+
+		return ret;
+	}
+
+	friend f32xn operator+( const f32xn &a, const f32xn &b ) {
+		return each( a, b, []( float p, float q ) { return p + q; } );
+	}
+
+	friend f32xn operator-( const f32xn &a, const f32xn &b ) {
+		return each( a, b, []( float p, float q ) { return p - q; } );
+	}
+
+	friend f32xn operator*( const f32xn &a, const f32xn &b ) {
+		return each( a, b, []( float p, float q ) { return p * q; } );
+	}
+
+	// a > b ? a : b, as maxps
+	friend f32xn max( const f32xn &a, const f32xn &b ) {
+		return each( a, b, []( float p, float q ) { return p > q ? p : q; } );
+	}
+
+	friend f32xn operator-( const f32xn &a ) {
+		return each( a, a, []( float p, float ) { return -p; } );
+	}
+
+	friend f32xn abs( const f32xn &a ) {
+		return each( a, a, []( float p, float ) { return std::fabs( p ); } );
+	}
+
+	friend f32xn sqrt( const f32xn &a ) {
+		return each( a, a, []( float p, float ) { return std::sqrt( p ); } );
+	}
+
+	friend f32xn rsqrt( const f32xn &a ) {
+		return each( a, a, []( float p, float ) { return 1.f / std::sqrt( p ); } );
+	}
+
+	// a0 b0 a1 b1 ... to p (2N floats)
+	friend void store_zip( float *p, const f32xn &a, const f32xn &b ) {
+		for ( size_t j = 0; j < N; ++j ) {
+			p[ 2 * j ] = a.v[ j ];
+			p[ 2 * j + 1 ] = b.v[ j ];
+		}
+	}
+};
+
+#if defined( VEC2X_SSE )
+template <>
+struct f32xn<4> {
+	__m128 v;
+
+	static f32xn set( float f ) {
+		return { _mm_set1_ps( f ) };
+	}
+
+	static f32xn load( const float *p ) {
+		return { _mm_loadu_ps( p ) };
+	}
+
+	void store( float *p ) const {
+		_mm_storeu_ps( p, v );
+	}
+
+	friend f32xn operator+( const f32xn &a, const f32xn &b ) {
+		return { _mm_add_ps( a.v, b.v ) };
+	}
+
+	friend f32xn operator-( const f32xn &a, const f32xn &b ) {
+		return { _mm_sub_ps( a.v, b.v ) };
+	}
+
+	friend f32xn operator*( const f32xn &a, const f32xn &b ) {
+		return { _mm_mul_ps( a.v, b.v ) };
+	}
+
+	friend f32xn max( const f32xn &a, const f32xn &b ) {
+		return { _mm_max_ps( a.v, b.v ) };
+	}
+
+	friend f32xn operator-( const f32xn &a ) {
+		return { _mm_xor_ps( a.v, _mm_set1_ps( -0.f ) ) };
+	}
+
+	friend f32xn abs( const f32xn &a ) {
+		return { _mm_andnot_ps( _mm_set1_ps( -0.f ), a.v ) };
+	}
+
+	friend f32xn sqrt( const f32xn &a ) {
+		return { _mm_sqrt_ps( a.v ) };
+	}
+
+	// y = rsqrtps( a ), then y * ( 1.5 - 0.5 * a * y * y ): about 23 bits
+	friend f32xn rsqrt( const f32xn &a ) {
+		const auto y = _mm_rsqrt_ps( a.v );
+		const auto ayy = _mm_mul_ps( _mm_mul_ps( a.v, y ), y );
+		return { _mm_mul_ps( y, _mm_sub_ps( _mm_set1_ps( 1.5f ), _mm_mul_ps( _mm_set1_ps( 0.5f ), ayy ) ) ) };
+	}
+
+	friend void store_zip( float *p, const f32xn &a, const f32xn &b ) {
+		_mm_storeu_ps( p, _mm_unpacklo_ps( a.v, b.v ) );
+		_mm_storeu_ps( p + 4, _mm_unpackhi_ps( a.v, b.v ) );
+	}
+};
+#endif
+
+#if defined( VEC2X_AVX )
+template <>
+struct f32xn<8> {
+	__m256 v;
+
+	static f32xn set( float f ) {
+		return { _mm256_set1_ps( f ) };
+	}
+
+	static f32xn load( const float *p ) {
+		return { _mm256_loadu_ps( p ) };
+	}
+
+	void store( float *p ) const {
+		_mm256_storeu_ps( p, v );
+	}
+
+	friend f32xn operator+( const f32xn &a, const f32xn &b ) {
+		return { _mm256_add_ps( a.v, b.v ) };
+	}
+
+	friend f32xn operator-( const f32xn &a, const f32xn &b ) {
+		return { _mm256_sub_ps( a.v, b.v ) };
+	}
+
+	friend f32xn operator*( const f32xn &a, const f32xn &b ) {
+		return { _mm256_mul_ps( a.v, b.v ) };
+	}
+
+	friend f32xn max( const f32xn &a, const f32xn &b ) {
+		return { _mm256_max_ps( a.v, b.v ) };
+	}
+
+	friend f32xn operator-( const f32xn &a ) {
+		return { _mm256_xor_ps( a.v, _mm256_set1_ps( -0.f ) ) };
+	}
+
+	friend f32xn abs( const f32xn &a ) {
+		return { _mm256_andnot_ps( _mm256_set1_ps( -0.f ), a.v ) };
+	}
+
+	friend f32xn sqrt( const f32xn &a ) {
+		return { _mm256_sqrt_ps( a.v ) };
+	}
+
+	friend f32xn rsqrt( const f32xn &a ) {
+		const auto y = _mm256_rsqrt_ps( a.v );
+		const auto ayy = _mm256_mul_ps( _mm256_mul_ps( a.v, y ), y );
+		return { _mm256_mul_ps( y, _mm256_sub_ps( _mm256_set1_ps( 1.5f ), _mm256_mul_ps( _mm256_set1_ps( 0.5f ), ayy ) ) ) };
+	}
+
+	// unpack works within the 128-bit halves: a0 b0 a1 b1 | a4 b4 a5 b5 and a2 b2 a3 b3 | a6 b6 a7 b7 -> in order
+	friend void store_zip( float *p, const f32xn &a, const f32xn &b ) {
+		const auto lo = _mm256_unpacklo_ps( a.v, b.v );
+		const auto hi = _mm256_unpackhi_ps( a.v, b.v );
+
+		_mm256_storeu_ps( p, _mm256_permute2f128_ps( lo, hi, 0x20 ) );
+		_mm256_storeu_ps( p + 8, _mm256_permute2f128_ps( lo, hi, 0x31 ) );
+	}
+};
+#elif defined( VEC2X_SSE )
+// Lanes 0..3 and 4..7
+template <>
+struct f32xn<8> {
+	f32xn<4> lo, hi;
+
+	static f32xn set( float f ) {
+		return { f32xn<4>::set( f ), f32xn<4>::set( f ) };
+	}
+
+	static f32xn load( const float *p ) {
+		return { f32xn<4>::load( p ), f32xn<4>::load( p + 4 ) };
+	}
+
+	void store( float *p ) const {
+		lo.store( p );
+		hi.store( p + 4 );
+	}
+
+	friend f32xn operator+( const f32xn &a, const f32xn &b ) {
+		return { a.lo + b.lo, a.hi + b.hi };
+	}
+
+	friend f32xn operator-( const f32xn &a, const f32xn &b ) {
+		return { a.lo - b.lo, a.hi - b.hi };
+	}
+
+	friend f32xn operator*( const f32xn &a, const f32xn &b ) {
+		return { a.lo * b.lo, a.hi * b.hi };
+	}
+
+	friend f32xn max( const f32xn &a, const f32xn &b ) {
+		return { max( a.lo, b.lo ), max( a.hi, b.hi ) };
+	}
+
+	friend f32xn operator-( const f32xn &a ) {
+		return { -a.lo, -a.hi };
+	}
+
+	friend f32xn abs( const f32xn &a ) {
+		return { abs( a.lo ), abs( a.hi ) };
+	}
+
+	friend f32xn sqrt( const f32xn &a ) {
+		return { sqrt( a.lo ), sqrt( a.hi ) };
+	}
+
+	friend f32xn rsqrt( const f32xn &a ) {
+		return { rsqrt( a.lo ), rsqrt( a.hi ) };
+	}
+
+	friend void store_zip( float *p, const f32xn &a, const f32xn &b ) {
+		store_zip( p, a.lo, b.lo );
+		store_zip( p + 8, a.hi, b.hi );
+	}
+};
+#endif
+
+using f32x4 = f32xn<4>;
+using f32x8 = f32xn<8>;
+
+// N points (SoA): lane j of x, y is point j
+template <size_t N>
+struct vec2xn {
+	using lane = f32xn<N>;
+
+	lane x, y;
+
+	// The same point in every lane
+	static vec2xn set( const vec2 &v ) {
+		return { lane::set( v.x ), lane::set( v.y ) };
+	}
+
+	// Points x[ 0 .. N ), y[ 0 .. N )
+	static vec2xn load( const float *px, const float *py ) {
+		return { lane::load( px ), lane::load( py ) };
+	}
+
+	// Points p[ 0 .. N ) (AoS)
+	static vec2xn load( const vec2 *p );
+
+	// To p[ 0 .. N ) (AoS)
+	void store( vec2 *p ) const {
+		store_zip( reinterpret_cast< float * >( p ), x, y );
+	}
+
+	friend vec2xn operator+( const vec2xn &a, const vec2xn &b ) {
+		return { a.x + b.x, a.y + b.y };
+	}
+
+	friend vec2xn operator-( const vec2xn &a, const vec2xn &b ) {
+		return { a.x - b.x, a.y - b.y };
+	}
+
+	// Every point by its own factor
+	friend vec2xn operator*( const vec2xn &a, const lane &s ) {
+		return { a.x * s, a.y * s };
+	}
+
+	friend vec2xn operator*( const vec2xn &a, float s ) {
+		return a * lane::set( s );
+	}
+
+	// Rotated by exactly 90 degrees counterclockwise, as vec2::perp
+	vec2xn perp( ) const {
+		return { -y, x };
+	}
+
+	// x * v.x + y * v.y, as vec2::dot_product
+	lane dot( const vec2xn &v ) const {
+		return x * v.x + y * v.y;
+	}
+
+	// The same floats as vec2::length
+	lane length( ) const {
+		return sqrt( dot( *this ) );
+	}
+
+	// By rsqrt( ): within a few ulps of vec2::normalized on SSE/AVX, zero points give NaN
+	vec2xn normalized( ) const {
+		return *this * rsqrt( dot( *this ) );
+	}
+};
+
+template <size_t N>
+vec2xn<N> vec2xn<N>::load( const vec2 *p ) {
+	vec2xn ret;
+	float fx[ N ], fy[ N ];
+	for ( size_t j = 0; j < N; ++j ) {
+		fx[ j ] = p[ j ].x;
+		fy[ j ] = p[ j ].y;
+	}
+
+	ret.x = lane::load( fx );
+	ret.y = lane::load( fy );
+	return ret;
+}
+
+#if defined( VEC2X_SSE )
+// x0 y0 x1 y1 | x2 y2 x3 y3 -> x0..x3, y0..y3
+template <>
+inline vec2xn<4> vec2xn<4>::load( const vec2 *p ) {
+	const auto *f = reinterpret_cast< const float * >( p );
+	const auto v0 = _mm_loadu_ps( f );
+	const auto v1 = _mm_loadu_ps( f + 4 );
+
+	return { { _mm_shuffle_ps( v0, v1, 0x88 ) }, { _mm_shuffle_ps( v0, v1, 0xDD ) } };
+}
+#endif
+
+#if defined( VEC2X_AVX )
+// Points 0, 1 | 4, 5 and 2, 3 | 6, 7, so the shuffles (within the halves) give x0..x7, y0..y7
+template <>
+inline vec2xn<8> vec2xn<8>::load( const vec2 *p ) {
+	const auto *f = reinterpret_cast< const float * >( p );
+	const auto v0 = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( f ) ), _mm_loadu_ps( f + 8 ), 1 );
+	const auto v1 = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( f + 4 ) ), _mm_loadu_ps( f + 12 ), 1 );
+
+	return { { _mm256_shuffle_ps( v0, v1, 0x88 ) }, { _mm256_shuffle_ps( v0, v1, 0xDD ) } };
+}
+#elif defined( VEC2X_SSE )
+template <>
+inline vec2xn<8> vec2xn<8>::load( const vec2 *p ) {
+	const auto lo = vec2xn<4>::load( p );
+	const auto hi = vec2xn<4>::load( p + 4 );
+
+	return { { lo.x, hi.x }, { lo.y, hi.y } };
+}
+#endif
+
+using vec2x4 = vec2xn<4>;
+using vec2x8 = vec2xn<8>;
+
+// Widest batch of the build: 8 with AVX, 4 otherwise
+#if defined( VEC2X_AVX )
+constexpr size_t vec2x_lanes = 8;
+#else
+constexpr size_t vec2x_lanes = 4;
+#endif